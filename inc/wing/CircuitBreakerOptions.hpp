@@ -0,0 +1,34 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace wing {
+
+/**
+ * Per server circuit breaker options.  Once too many of a server's queries fail to connect, lose
+ * their connection or time out the breaker opens and new queries for the server complete with
+ * CIRCUIT_OPEN without executing.  After the cool down the breaker half opens and lets a few
+ * probe queries through, it closes again if they succeed and re-opens if one fails.
+ */
+struct CircuitBreakerOptions {
+    /// The ratio of failed queries within a window that opens the breaker, e.g. 0.5.  A value of
+    /// 0 disables the circuit breaker.
+    double failure_ratio { 0.0 };
+    /// The minimum number of queries within a window before the failure ratio is checked, so a
+    /// single failure on a quiet server doesn't open the breaker.
+    std::size_t min_queries { 20 };
+    /// The length of the window the failure ratio is counted over.
+    std::chrono::milliseconds window { 10000 };
+    /// How long the breaker stays open before it half opens.
+    std::chrono::milliseconds cool_down { 5000 };
+    /// The number of probe queries let through while half open, all of them must succeed to
+    /// close the breaker.
+    std::size_t half_open_queries { 1 };
+    /// How long a half open breaker waits for all of its probes to report before it re-opens, a
+    /// probe that never reports would otherwise keep the breaker half open.  A value of 0 uses
+    /// the cool down.
+    std::chrono::milliseconds half_open_timeout { 0 };
+};
+
+} // wing
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace wing {
+
+/**
+ * Adaptive per server concurrency limits.  Every server's limit on concurrently executing
+ * queries grows by one for every limit's worth of queries that complete within the latency
+ * tolerance while the limit is in use, and shrinks by the backoff ratio whenever a query is
+ * slower than the tolerance allows, fails to reach the server or loses its connection (AIMD).
+ * A query over the limit is parked on its server's pool without holding up a worker, it is
+ * queued again as soon as a slot frees up or shed with `QueryStatus::OVERLOADED` once it has
+ * waited the max wait.  Statements of a transaction after its BEGIN are never limited.
+ */
+struct ConcurrencyLimitOptions {
+    /// The limit every server starts with.  A value of 0 disables the adaptive limits, the
+    /// number of workers and the pools' max connections then bound the concurrency.
+    std::size_t initial_limit { 0 };
+    /// The smallest limit a server shrinks to.
+    std::size_t min_limit { 1 };
+    /// The largest limit a server grows to.
+    std::size_t max_limit { 256 };
+    /// How many times slower than the server's long term average latency a query may be before
+    /// it is treated as a sign of overload.
+    double latency_tolerance { 2.0 };
+    /// The factor the limit is multiplied by on every sign of overload.
+    double backoff_ratio { 0.9 };
+    /// How long a query waits for its server to drop under the limit before it is shed, parked
+    /// queries are shed as the admitted queries finish.  A value of 0 sheds right away.
+    std::chrono::milliseconds max_wait { 1000 };
+};
+
+} // wing
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "wing/ConnectionInfo.hpp"
+#include "wing/QueryPoolOptions.hpp"
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <mysql/mysql.h>
+
+namespace wing {
+
+class QueryPool;
+class Query;
+class Executor;
+class TransactionSession;
+
+/**
+ * A pooled MySQL client connection.  A connection is only checked out of its QueryPool while
+ * a query executes on it, or while it is pinned to a transaction, the query's results live
+ * independently of the connection.
+ */
+class Connection {
+    friend QueryPool;
+    friend Query;
+    friend Executor;
+    friend TransactionSession;
+
+public:
+    ~Connection();
+
+    Connection(const Connection&) = delete;
+    Connection(Connection&&) = delete;
+    auto operator=(const Connection&) noexcept -> Connection& = delete;
+    auto operator=(Connection&&) noexcept -> Connection& = delete;
+
+private:
+    /**
+     * @param query_pool The pool this connection belongs to.
+     * @param connection_info The MySQL server to connect to.
+     */
+    Connection(
+        QueryPool& query_pool,
+        const ConnectionInfo& connection_info);
+
+    /**
+     * If the connection has not yet connected, this will block and connect.  The attempt may
+     * wait for one of the pool's concurrent connect slots, or fail without contacting the server
+     * while the pool is backing off after connect failures.  A connection whose background connect
+     * failed is not retried.
+     * @return True on connected, false on failure.
+     */
+    auto connect() -> bool;
+
+    /**
+     * Sets the read timeout for the next statement executed on this connection.
+     * @param timeout The timeout, rounded down to seconds.
+     */
+    auto setReadTimeout(
+        std::chrono::milliseconds timeout) -> void;
+
+    /**
+     * Sets the connect timeout for the next connect on this connection.
+     * @param timeout The timeout, rounded down to seconds with a minimum of one second.
+     */
+    auto setConnectTimeout(
+        std::chrono::milliseconds timeout) -> void;
+
+    /**
+     * Executes a statement that has no result set, e.g. BEGIN, COMMIT or ROLLBACK.
+     * @param statement The raw SQL statement to execute.
+     * @return True if the statement succeeded.
+     */
+    auto executeControl(
+        std::string_view statement) -> bool;
+
+    /**
+     * Classifies the connection's last error by `mysql_errno`.  Server side SQL errors, e.g. a
+     * duplicate key or a syntax error, leave the connection usable while client errors, e.g. a
+     * failed connect, a lost connection or a read timeout, and a server shutdown do not.
+     * @return True if the connection can't be re-used and must be closed.
+     */
+    auto isBroken() -> bool;
+
+    /**
+     * Checks the connection is still alive with `mysql_ping()`, the connection is not
+     * automatically reconnected if it was lost.
+     * @return True if the connection is alive.
+     */
+    auto ping() -> bool;
+
+    /**
+     * Resets the connection's session with `mysql_reset_connection()` if the reset policy
+     * requires it, the connection stays connected.  The pool's session init statement is
+     * executed again after a reset.
+     * @param policy The pool's connection reset policy.
+     * @return False if the reset failed and the connection can't be re-used.
+     */
+    auto resetSession(
+        ConnectionResetPolicy policy) -> bool;
+
+    /**
+     * @return The GTID set of the transaction the last statement committed, as reported by
+     *         `session_track_gtids`, or empty if it committed none or tracking is disabled.
+     */
+    auto trackedGtids() -> std::string;
+
+    /**
+     * Waits for this server to apply a GTID set with `WAIT_FOR_EXECUTED_GTID_SET()`, the
+     * connection is connected first if needed.
+     * @param gtid_set The GTID set to wait for.
+     * @param timeout How long to wait.
+     * @return True if the server has applied the GTID set.
+     */
+    auto waitForGtids(
+        const std::string& gtid_set,
+        std::chrono::milliseconds timeout) -> bool;
+
+    /**
+     * Samples how far behind its source this replica is.
+     * @param statement A statement returning the lag in seconds as the first column of its first
+     *                  row, e.g. from a heartbeat table.  If empty `SHOW REPLICA STATUS` is used,
+     *                  falling back to `SHOW SLAVE STATUS` for older servers.
+     * @return The replication lag, or nullopt if the statement failed, replication isn't running
+     *         or the server isn't a replica.
+     */
+    auto replicationLag(
+        const std::string& statement) -> std::optional<std::chrono::milliseconds>;
+
+    /**
+     * Applies the TCP keepalive and nodelay connection options to the connected socket.
+     */
+    auto setSocketOptions() -> void;
+
+    /**
+     * Applies the socket options again if the client library silently reconnected since they
+     * were last applied, the new socket starts out with the system defaults.
+     */
+    auto refreshSocketOptions() -> void;
+
+    /**
+     * Enables or disables automatically reconnecting if the connection is lost, this must be
+     * disabled while the connection is pinned to a transaction otherwise statements after a
+     * lost connection would silently execute outside of the transaction.
+     * @param reconnect True to enable automatic reconnects.
+     */
+    auto setReconnect(
+        bool reconnect) -> void;
+
+    /// The pool this connection belongs to.
+    QueryPool& m_query_pool;
+    /// Connection information for the MySQL server.
+    const ConnectionInfo& m_connection_info;
+    MYSQL m_mysql;
+    /// Has this MySQL client connected to the server yet?
+    bool m_is_connected { false };
+    /// Did the last connect fail because the pool is backing off after connect failures?
+    bool m_connect_throttled { false };
+    /// Did a background connector already fail to connect this connection?  It is not retried,
+    /// the query it is handed to reports the failure.
+    bool m_connect_failed { false };
+    /// When this MySQL client connected to the server.
+    std::chrono::steady_clock::time_point m_connected_at {};
+    /// The server's thread id for the socket the options were applied to, an automatic
+    /// reconnect changes it.
+    unsigned long m_socket_thread_id { 0 };
+    /// Has a statement that may have changed the session been executed on this connection since
+    /// it was last reset?
+    bool m_session_changed { false };
+    /// When this connection was last returned to its pool.
+    std::chrono::steady_clock::time_point m_idle_since {};
+    /// When this idle connection was last pinged.
+    std::chrono::steady_clock::time_point m_pinged_at {};
+    /// Is this connection counted by its pool?  Control connections are opened outside of it.
+    bool m_pooled { true };
+};
+
+} // wing
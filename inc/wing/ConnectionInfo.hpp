@@ -1,5 +1,7 @@
 #pragma once
 
+#include "wing/ConnectionOptions.hpp"
+
 #include <string>
 
 namespace wing {
@@ -14,6 +16,7 @@ public:
      * @param password The password to authenticate with.
      * @param database The database to use upon connecting (optional).
      * @param client_flags MySQL client flags (optional).
+     * @param options Client connection options (optional).
      */
     ConnectionInfo(
         std::string host,
@@ -21,7 +24,8 @@ public:
         std::string user,
         std::string password,
         std::string database = "",
-        uint64_t client_flags = 0);
+        uint64_t client_flags = 0,
+        ConnectionOptions options = ConnectionOptions {});
 
     /**
      * Creates connection information for which MySQL server to connect to.
@@ -30,13 +34,15 @@ public:
      * @param password The password to authenticate with.
      * @param database The database to use upon connecting (optional).
      * @param client_flags MySQL client flags (optional).
+     * @param options Client connection options (optional).
      */
     ConnectionInfo(
         std::string socket,
         std::string user,
         std::string password,
         std::string database = "",
-        uint64_t client_flags = 0);
+        uint64_t client_flags = 0,
+        ConnectionOptions options = ConnectionOptions {});
 
     /**
      * @return The MySQL server hostname.
@@ -73,6 +79,11 @@ public:
      */
     auto ClientFlags() const -> uint64_t { return m_client_flags; }
 
+    /**
+     * @return The client connection options.
+     */
+    auto Options() const -> const ConnectionOptions& { return m_options; }
+
 private:
     std::string m_host;
     uint16_t m_port;
@@ -81,6 +92,7 @@ private:
     std::string m_password;
     std::string m_database;
     uint64_t m_client_flags;
+    ConnectionOptions m_options;
 };
 
 } // wing
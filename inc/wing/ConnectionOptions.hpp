@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace wing {
+
+/**
+ * Protocol compression between the client and the MySQL server, compression trades CPU for
+ * bandwidth and pays off for large result sets over slower networks.
+ */
+enum class CompressionAlgorithm {
+    /// The protocol is not compressed.
+    NONE,
+    /// zlib compression, supported by every server.
+    ZLIB,
+    /// zstd compression, requires a MySQL 8.0.18 or newer client and server.  If the client
+    /// library was built without compression algorithm support (WING_MYSQL_OPT_COMPRESSION_ALGORITHMS_DISABLED)
+    /// zlib is used instead.
+    ZSTD
+};
+
+/**
+ * Client connection options applied to every connection made with a ConnectionInfo, the
+ * defaults match the client library's defaults except for the short connect timeout.
+ */
+struct ConnectionOptions {
+    /// How long to wait for the server to accept the connection and finish the handshake,
+    /// rounded down to seconds with a minimum of one second.
+    std::chrono::milliseconds connect_timeout { 1000 };
+    /// How long a write to the server may block, rounded down to seconds.  A value of 0 uses the
+    /// client library's default.
+    std::chrono::milliseconds write_timeout { 0 };
+    /// Protocol compression.
+    CompressionAlgorithm compression { CompressionAlgorithm::NONE };
+    /// The zstd compression level from 1 to 22, ignored by other algorithms.
+    uint32_t compression_level { 3 };
+    /// The largest packet the client will send or receive in bytes, large rows and results of
+    /// analytics queries may need more than the client's default.  A value of 0 uses the client
+    /// library's default.
+    uint64_t max_allowed_packet { 0 };
+    /// The character set for the connection, e.g. "utf8mb4".  Empty uses the client library's
+    /// default.
+    std::string charset {};
+    /// Are lost connections automatically reconnected?  Connections pinned to a transaction are
+    /// never reconnected.
+    bool auto_reconnect { true };
+    /// Enables TCP keepalive probes on the connection's socket.
+    bool tcp_keepalive { true };
+    /// How long the socket is idle before the first TCP keepalive probe is sent, rounded down to
+    /// seconds.  A value of 0 uses the operating system's default.
+    std::chrono::milliseconds tcp_keepalive_idle { 0 };
+    /// Disables Nagle's algorithm so small requests are sent immediately, low latency workloads
+    /// should leave this enabled.
+    bool tcp_nodelay { true };
+};
+
+} // wing
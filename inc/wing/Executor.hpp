@@ -1,25 +1,181 @@
 #pragma once
 
+#include "wing/ExecutorOptions.hpp"
+#include "wing/QueryOptions.hpp"
 #include "wing/QueryPool.hpp"
+#include "wing/ResultCache.hpp"
+#include "wing/Transaction.hpp"
 
 #include <atomic>
 #include <condition_variable>
 #include <deque>
+#include <functional>
 #include <future>
+#include <map>
 #include <mutex>
+#include <random>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace wing {
 
 class Executor;
 
+/**
+ * Queries waiting for a worker.  The Executor's workers share a single queue unless
+ * `ExecutorOptions::shared_nothing` is set, then every worker has its own queue.
+ *
+ * Every tenant, see `QueryOptions::tenant`, has its own sub-queue and the tenants are served by
+ * weighted fair queuing: each served query advances its tenant's virtual time by the inverse of
+ * the tenant's weight and the tenant with the lowest virtual time is served next.  A tenant that
+ * had nothing queued starts at the queue's current virtual time, so idle tenants can't save up
+ * a burst.  Queries of the same tenant are served in order.  All of the callers must hold the
+ * queue's mutex.
+ */
+class QueryQueue {
+    friend Executor;
+    friend TransactionSession;
+
+public:
+    ~QueryQueue() = default;
+
+    QueryQueue(const QueryQueue&) = delete;
+    QueryQueue(QueryQueue&&) = delete;
+    auto operator=(const QueryQueue&) noexcept -> QueryQueue& = delete;
+    auto operator=(QueryQueue&&) noexcept -> QueryQueue& = delete;
+
+private:
+    /**
+     * A tenant's queued queries.
+     */
+    struct TenantQueue {
+        /// The tenant's queries in the order they were queued.
+        std::deque<QueryHandle> m_queries {};
+        /// The tenant's virtual time, the position of its first query in m_schedule.
+        std::pair<double, uint64_t> m_scheduled_at {};
+        /// The tenant's weight when its last query was queued.
+        double m_weight { 1.0 };
+        /// The tenant's key in m_tenants.
+        const std::string* m_tenant { nullptr };
+    };
+
+    QueryQueue() = default;
+
+    /**
+     * @return True if there are no queued queries.
+     */
+    auto empty() const -> bool { return m_size == 0; }
+
+    /**
+     * Queues a query at the back of its tenant's sub-queue.
+     * @param query_handle The query to queue.
+     * @param weight The weight of the query's tenant.
+     * @param front Serve the query ahead of every tenant, e.g. a hedged read's duplicate.
+     */
+    auto push(
+        QueryHandle query_handle,
+        double weight,
+        bool front) -> void;
+
+    /**
+     * Takes the next query to execute, the queue must not be empty.
+     * @return The first query of the tenant with the lowest virtual time.
+     */
+    auto pop() -> QueryHandle;
+
+    /**
+     * Takes the tenant's next query if it may be group committed, batches never reorder a
+     * tenant's queries.
+     * @param tenant The tenant of the batch.
+     * @return The query, or nullopt if the tenant's next query can't join the batch.
+     */
+    auto popGroupCommit(
+        const std::string& tenant) -> std::optional<QueryHandle>;
+
+    /**
+     * Takes the tenant's first query and advances its virtual time.
+     * @param tenant_queue The tenant's sub-queue, erased if it is now empty.
+     * @return The query.
+     */
+    auto take(
+        TenantQueue& tenant_queue) -> QueryHandle;
+
+    std::condition_variable m_wait_cv {};
+    std::mutex m_mutex {};
+    /// Queries that are served ahead of the tenants.
+    std::deque<QueryHandle> m_urgent {};
+    /// Sub-queues of the tenants with queued queries.
+    std::unordered_map<std::string, TenantQueue> m_tenants {};
+    /// The tenants with queued queries by virtual time, ties are served in the order they were
+    /// scheduled.
+    std::map<std::pair<double, uint64_t>, TenantQueue*> m_schedule {};
+    /// Breaks virtual time ties.
+    uint64_t m_schedule_sequence { 0 };
+    /// The virtual time of the last served tenant.
+    double m_virtual_time { 0.0 };
+    /// The number of queued queries.
+    std::size_t m_size { 0 };
+    /// The number of queries assigned to this queue that are waiting or executing.
+    std::atomic<uint64_t> m_active_query_count { 0 };
+};
+
+/**
+ * The shared state of a hedged read's attempts, the read's original query and the duplicate
+ * that is sent to another replica if the original is slow.  The first attempt to succeed, or
+ * the last attempt to finish if none succeed, completes the read.
+ */
+class HedgedRead {
+    friend Executor;
+
+public:
+    ~HedgedRead() = default;
+
+    HedgedRead(const HedgedRead&) = delete;
+    HedgedRead(HedgedRead&&) = delete;
+    auto operator=(const HedgedRead&) noexcept -> HedgedRead& = delete;
+    auto operator=(HedgedRead&&) noexcept -> HedgedRead& = delete;
+
+private:
+    /**
+     * An attempt executing on a server.
+     */
+    struct Attempt {
+        /// Identifies the attempt within the read, a retried attempt can land on the same server.
+        uint64_t m_id;
+        /// The pool of the server the attempt executes on.
+        QueryPool* m_query_pool;
+        /// The server's id of the connection executing the attempt, 0 if it isn't connected.
+        unsigned long m_thread_id;
+    };
+
+    HedgedRead() = default;
+
+    std::mutex m_lock {};
+    /// The read's on complete callback, handed to the winning attempt.
+    std::function<void(QueryHandle)> m_on_complete {};
+    /// The duplicate, empty once it has been sent or the read has finished.
+    std::optional<QueryHandle> m_duplicate {};
+    /// The Executor queue the duplicate is assigned to.
+    std::size_t m_duplicate_queue_index { 0 };
+    /// Has the duplicate been scheduled to be sent once the hedge delay passes?
+    bool m_scheduled { false };
+    /// The number of attempts that have been sent and not yet finished.
+    std::size_t m_outstanding { 1 };
+    /// Has an attempt completed the read?
+    bool m_finished { false };
+    /// The attempts currently executing, the losers are killed once the read has finished.
+    std::vector<Attempt> m_executing {};
+    /// The id of the last attempt that started executing.
+    uint64_t m_last_attempt_id { 0 };
+};
+
 class Worker {
     friend Executor;
 
 public:
     Worker(const Worker&) = delete;
-    Worker(Worker&&) = default;
+    Worker(Worker&& other);
     auto operator=(const Worker&) -> Worker& = delete;
     auto operator=(Worker &&) -> Worker& = delete;
 
@@ -45,6 +201,16 @@ public:
      */
     [[nodiscard]] auto OperatingSystemThreadId() const -> const std::optional<pid_t>& { return m_tid; }
 
+    /**
+     * @return The number of queries this worker has taken from its queue and completed.
+     */
+    [[nodiscard]] auto CompletedQueryCount() const -> uint64_t { return m_completed_query_count.load(std::memory_order_relaxed); }
+
+    /**
+     * @return The number of idle connections this worker has cached for its next queries.
+     */
+    [[nodiscard]] auto CachedConnectionCount() const -> std::size_t { return m_cached_connection_count.load(std::memory_order_relaxed); }
+
 private:
     Worker(
         std::thread thread);
@@ -55,18 +221,43 @@ private:
     const std::uint64_t m_worker_idx { ++g_worker_idx };
     std::optional<std::thread::native_handle_type> m_native_handle;
     std::optional<pid_t> m_tid;
+    /// Connections cached by this worker between queries, only touched by the worker's thread.
+    std::vector<std::unique_ptr<Connection>> m_connections {};
+    /// Only written by the worker's thread.
+    std::atomic<uint64_t> m_completed_query_count { 0 };
+    /// The size of m_connections, only written by the worker's thread.
+    std::atomic<std::size_t> m_cached_connection_count { 0 };
 };
 
 class Executor {
     friend Worker;
+    friend TransactionSession;
 
 public:
     /**
      * @param connection_info The connection information for the MySQL Server.
+     * @param num_workers The number of worker threads executing queries.
+     * @param options Executor wide tuning options.
      */
     explicit Executor(
         ConnectionInfo connection_info,
-        std::size_t num_workers = 1);
+        std::size_t num_workers = 1,
+        ExecutorOptions options = ExecutorOptions {});
+
+    /**
+     * Creates an Executor that splits reads and writes between a primary and its replicas, every
+     * server has its own QueryPool with the same pool options.  Writes and transactions execute
+     * on the primary and reads are spread across the replicas, see `QueryOptions::route`.
+     * @param primary The connection information for the primary MySQL Server.
+     * @param replicas The connection information for the replica MySQL Servers.
+     * @param num_workers The number of worker threads executing queries on every server.
+     * @param options Executor wide tuning options.
+     */
+    Executor(
+        ConnectionInfo primary,
+        std::vector<ConnectionInfo> replicas,
+        std::size_t num_workers = 1,
+        ExecutorOptions options = ExecutorOptions {});
 
     ~Executor();
 
@@ -78,7 +269,7 @@ public:
     /**
      * @return The number of queries that are activitely executing and waiting to be executed.
      */
-    [[nodiscard]] auto ActiveQueryCount() const -> uint64_t { return m_active_query_count; }
+    [[nodiscard]] auto ActiveQueryCount() const -> uint64_t;
 
     /**
      * Stops the `Executor` workers and prevents futher queries submitted via
@@ -90,23 +281,47 @@ public:
      */
     auto Stop() -> void
     {
-        m_stop = true;
-        m_wait_cv.notify_all();
+        {
+            // The retrier only queues a retry while holding this lock and m_stop is unset.
+            std::lock_guard<std::mutex> guard { m_retry_mutex };
+            m_stop = true;
+            m_retry_cv.notify_all();
+        }
+
+        for (auto& queue : m_queues) {
+            queue->m_wait_cv.notify_all();
+        }
+
+        {
+            std::lock_guard<std::mutex> guard { m_monitor_mutex };
+            m_monitor_cv.notify_all();
+        }
+
+        std::lock_guard<std::mutex> guard { m_hedge_mutex };
+        m_hedge_cv.notify_all();
     }
 
+    /**
+     * @return The Executor's result cache, or nullptr if the result cache is disabled.
+     */
+    auto Cache() -> ResultCache* { return m_result_cache.get(); }
+
     /**
      * Starts a query with the given statement, timeout and on complete callback.  The on complete
-     * callback will be call on the worker when the query is completed or timed out.
+     * callback will be call on the worker when the query is completed or timed out.  Queries served
+     * from the result cache are also completed on a worker.
      * @param statement The statement to execute.
      * @param timeout The timeout for this query.
      * @param on_complete The on complete callback handler, this is called on the worker that
      *                    executed the query.
+     * @param options Execution hints for this query.
      * @return True if the query has been started or queued for execution.
      */
     [[nodiscard]] auto StartQuery(
         wing::Statement statement,
         std::chrono::milliseconds timeout,
-        std::function<void(QueryHandle)> on_complete) -> bool;
+        std::function<void(QueryHandle)> on_complete,
+        QueryOptions options = QueryOptions {}) -> bool;
 
     /**
      * Starts a query with the given statement and timeout.  If the query is started or queued
@@ -114,12 +329,24 @@ public:
      * is completed.  The future can be blocked on until the query is completed.
      * @param statement The statement to execute.
      * @param timeout The timeout for this query.
+     * @param options Execution hints for this query.
      * @return If the query is queued for execution then a future is returned to block on until
      *         the query is completed or times out.
      */
     [[nodiscard]] auto StartQuery(
         wing::Statement statement,
-        std::chrono::milliseconds timeout) -> std::optional<std::future<QueryHandle>>;
+        std::chrono::milliseconds timeout,
+        QueryOptions options = QueryOptions {}) -> std::optional<std::future<QueryHandle>>;
+
+    /**
+     * Starts a transaction that pins a single pooled connection for all of its statements,
+     * BEGIN is queued for execution immediately.  See `Transaction` for details.
+     * @param timeout The timeout for the BEGIN statement, this is also used for the automatic
+     *                ROLLBACK if the transaction is destroyed before it ends.
+     * @return The transaction if it has been started.
+     */
+    [[nodiscard]] auto StartTransaction(
+        std::chrono::milliseconds timeout) -> std::optional<Transaction>;
 
     /**
      * Gets the execution context's worker pool threads.  This can be useful for renaming
@@ -128,20 +355,342 @@ public:
     auto Workers() const -> const std::vector<Worker>& { return m_workers; }
 
 private:
+    ExecutorOptions m_options;
+    /// The primary's pool, writes and transactions always execute on the primary.
     QueryPool m_query_pool;
+    /// A pool per replica, empty if reads execute on the primary.
+    std::vector<std::unique_ptr<QueryPool>> m_replica_pools {};
+    /// Round robin position for spreading reads across the replicas with round robin balancing.
+    std::atomic<uint64_t> m_next_replica { 0 };
+    /// The standby's pool, nullptr if there is no standby.
+    std::unique_ptr<QueryPool> m_standby_pool { nullptr };
+    /// A control connection per replica for sampling its replication lag, only touched by the
+    /// monitor.  Pooled connections would keep the sample's read timeout for later queries.
+    std::vector<std::unique_ptr<Connection>> m_lag_connections {};
+    /// Wakes the monitor when the Executor stops or a query is parked by the concurrency limit.
+    std::mutex m_monitor_mutex {};
+    std::condition_variable m_monitor_cv {};
+    /// Set when a query is parked so the monitor re-computes when to shed it.
+    bool m_monitor_parked { false };
+    /// Samples the replicas' replication lag, probes every server's health and sheds queries
+    /// parked past the concurrency limit's max wait, only started if any is enabled.
+    std::optional<std::thread> m_monitor_thread {};
+    /// Read through cache of query results, only created if enabled in the options.
+    std::unique_ptr<ResultCache> m_result_cache { nullptr };
 
     std::atomic<bool> m_start { false };
     std::atomic<bool> m_stop { false };
-    std::atomic<uint64_t> m_active_query_count { 0 };
 
     std::vector<Worker> m_workers {};
 
-    std::condition_variable m_wait_cv {};
-    std::mutex m_query_queue_mutex {};
-    std::deque<QueryHandle> m_query_queue {};
+    /// A single queue shared by all workers, or one queue per worker if shared nothing.
+    std::vector<std::unique_ptr<QueryQueue>> m_queues {};
+    /// Round robin position for assigning queries to queues, only touched by submitters.
+    std::atomic<uint64_t> m_next_queue { 0 };
+
+    /// Guards the retry budget and the queries waiting to be retried.
+    std::mutex m_retry_mutex {};
+    std::condition_variable m_retry_cv {};
+    /// The number of retries the budget currently allows.
+    double m_retry_budget { 0.0 };
+    /// Queries waiting for their retry backoff to pass, by the time they are retried.
+    std::multimap<std::chrono::steady_clock::time_point, QueryHandle> m_retries {};
+    /// Jitters the retry backoff.
+    std::minstd_rand m_retry_random { std::random_device {}() };
+    /// Hands queries back to the workers once their retry backoff has passed, only started if
+    /// retries are enabled.
+    std::optional<std::thread> m_retry_thread {};
+
+    /// Guards the hedge delay, the read latency samples and the hedged reads waiting to be sent
+    /// or cancelled.
+    std::mutex m_hedge_mutex {};
+    std::condition_variable m_hedge_cv {};
+    /// Recent read latencies in a ring, the hedge delay is their configured percentile.
+    std::vector<std::chrono::microseconds> m_hedge_samples {};
+    /// The ring position the next read latency is written to.
+    std::size_t m_hedge_sample_next { 0 };
+    /// The number of read latencies recorded since the hedge delay was last computed.
+    std::size_t m_hedge_samples_pending { 0 };
+    /// How long a read executes before it is hedged, nullopt until enough latencies are known.
+    std::optional<std::chrono::microseconds> m_hedge_delay {};
+    /// Hedged reads by the time their duplicate is sent.
+    std::multimap<std::chrono::steady_clock::time_point, std::shared_ptr<HedgedRead>> m_hedges {};
+    /// Finished hedged reads with losing attempts still executing.
+    std::vector<std::shared_ptr<HedgedRead>> m_hedge_cancels {};
+    /// A control connection per pool for killing losing attempts, only touched by the hedger.
+    /// Taking a pooled connection could wait out the pool's max wait behind the slow server.
+    std::unordered_map<QueryPool*, std::unique_ptr<Connection>> m_kill_connections {};
+    /// Sends the duplicates of slow reads and kills the losing attempts, only started if
+    /// hedging is enabled.
+    std::optional<std::thread> m_hedge_thread {};
+
+    /// Guards m_single_flights.
+    std::mutex m_single_flight_mutex {};
+    /// In flight single flight reads by statement key, each with the queries waiting to share its result.
+    std::unordered_map<std::string, std::vector<QueryHandle>> m_single_flights {};
 
     auto executor(
         std::size_t worker_index) -> void;
+
+    /**
+     * @param tenant The tenant, see `QueryOptions::tenant`.
+     * @return The tenant's weight from `ExecutorOptions::tenant_weights`, 1 if it has none.
+     */
+    auto tenantWeight(
+        const std::string& tenant) const -> double;
+
+    /**
+     * Picks the queue for a new query or transaction, queries with the same shard key always
+     * go to the same queue and queries without one are assigned round robin.
+     * @param options The query's options.
+     * @return The index of the queue in m_queues.
+     */
+    auto queueFor(
+        const QueryOptions& options) -> std::size_t;
+
+    /**
+     * Picks the server a query executes on, replica eligible queries are spread across the
+     * healthy replicas that are fresh enough for the query's max staleness.
+     * @param query The query to route.
+     * @return The pool of the chosen server.
+     */
+    auto route(
+        const Query& query) -> QueryPool&;
+
+    /**
+     * @param query The replica eligible query to route.
+     * @return The healthy replicas that are fresh enough for the query's max staleness.
+     */
+    auto replicaCandidates(
+        const Query& query) -> std::vector<QueryPool*>;
+
+    /**
+     * Picks one of the candidate replicas by `ExecutorOptions::replica_balancing`.
+     * @param count The number of candidates, at least one.
+     * @param pool_at Returns the candidate at an index.
+     * @return The pool of the chosen replica.
+     */
+    template<typename PoolAt>
+    auto balance(
+        std::size_t count,
+        PoolAt pool_at) -> QueryPool&;
+
+    /**
+     * @return The pool writes and transactions execute on, the primary or the standby if the
+     *         primary has failed over.
+     */
+    auto primary() -> QueryPool&;
+
+    /**
+     * Background loop sampling every replica's replication lag and probing every server's
+     * health at their configured intervals, and shedding parked queries once they have waited
+     * the concurrency limit's max wait.
+     */
+    auto monitor() -> void;
+
+    /**
+     * Samples every replica's replication lag.
+     */
+    auto sampleReplicationLag() -> void;
+
+    /**
+     * Probes the primary, every replica and the standby.
+     */
+    auto probeHealth() -> void;
+
+    /**
+     * Queues a query on its assigned queue for a worker to execute, the caller must have already
+     * counted the query in its queue's active query count.
+     * @param query_handle The query to execute.
+     * @param front Queue the query ahead of the waiting queries, e.g. a hedged read's duplicate.
+     */
+    auto enqueue(
+        QueryHandle query_handle,
+        bool front = false) -> void;
+
+    /**
+     * Executes a query on a connection checked out of the pool, or on its transaction's pinned
+     * connection, then hands it to complete().  The connection is returned to the pool before
+     * the on complete callback is called.  If no connection is available within
+     * `QueryPoolOptions::max_wait` the query completes with a CONNECT_FAILURE.
+     * @param worker The worker executing the query.
+     * @param query_handle The query to execute.
+     */
+    auto execute(
+        Worker& worker,
+        QueryHandle query_handle) -> void;
+
+    /**
+     * Admits a query that is about to check a connection out of its target pool with the pool's
+     * concurrency limit and circuit breaker, a query that isn't admitted has an outcome.
+     * @param query_handle The query to admit.
+     * @param limited_pool Set to the pool if the concurrency limit admitted the query, already
+     *                     set if the query was admitted while it was parked.
+     * @param circuit_admitted Set if the circuit breaker admitted the query.
+     * @return False if the query was parked, the pool owns it until it is queued again.
+     */
+    auto admit(
+        QueryHandle& query_handle,
+        QueryPool*& limited_pool,
+        bool& circuit_admitted) -> bool;
+
+    /**
+     * Wakes the monitor after a query was parked by the concurrency limit.
+     */
+    auto parked() -> void;
+
+    /**
+     * Queues the queries handed back by a pool's concurrency limit, either admitted or shed.
+     * @param query_handles The formerly parked queries.
+     */
+    auto resume(
+        std::vector<QueryHandle> query_handles) -> void;
+
+    /**
+     * Checks out a connection to the pool's server from the worker's cache, or from the pool if
+     * the cache has none.
+     * @param worker The worker executing the query.
+     * @param query_pool The pool of the server to execute on.
+     * @return A connection, or nullptr if none was available within the pool's max wait.
+     */
+    auto acquire(
+        Worker& worker,
+        QueryPool& query_pool) -> std::unique_ptr<Connection>;
+
+    /**
+     * Returns a connection to the worker's cache, or to its pool if the cache is full.
+     * @param worker The worker that executed on the connection.
+     * @param connection The connection to return.
+     */
+    auto release(
+        Worker& worker,
+        std::unique_ptr<Connection> connection) -> void;
+
+    /**
+     * Hands all of the worker's cached connections back to their pools.
+     * @param worker The worker to flush.
+     */
+    auto flush(
+        Worker& worker) -> void;
+
+    /**
+     * @return How long a worker's cached connection can be idle before it is handed back to its
+     *         pool, the pool's idle timeout or its maintenance interval if there is none.
+     */
+    auto reclaimTimeout() const -> std::chrono::milliseconds;
+
+    /**
+     * Hands the worker's cached connections that have been idle longer than the reclaim timeout,
+     * or whose pool is at capacity, back to their pools.
+     * @param worker The idle worker.
+     */
+    auto reclaim(
+        Worker& worker) -> void;
+
+    /**
+     * Pings the worker's cached connections that have been idle longer than the pool's keepalive
+     * interval, dead connections are closed.
+     * @param worker The idle worker.
+     */
+    auto keepalive(
+        Worker& worker) -> void;
+
+    /**
+     * Executes a batch of group commit eligible writes inside a single transaction on a
+     * single pooled connection.  If any write or the transaction itself fails (and the server
+     * is known to have rolled it back) every write is executed individually instead.  The
+     * batch is admitted once through its first write, if that write is parked the batch's
+     * handles are moved out and parked or queued again behind it.
+     * @param worker The worker executing the batch.
+     * @param batch The writes to coalesce, must contain at least one query.
+     */
+    auto executeGroupCommit(
+        Worker& worker,
+        std::vector<QueryHandle>& batch) -> void;
+
+    /**
+     * Schedules a failed query to be retried if its error is transient, it may be retried and the
+     * retry budget allows it.  The query is executed again once its backoff has passed.
+     * @param query_handle The failed query, moved from if it will be retried.
+     * @return True if the query will be retried.
+     */
+    auto retry(
+        QueryHandle& query_handle) -> bool;
+
+    /**
+     * Background loop handing queries back to the workers once their retry backoff has passed,
+     * queries still waiting when the Executor stops complete with their last error.
+     */
+    auto retrier() -> void;
+
+    /**
+     * @return The current hedge delay, nullopt if hedging is disabled or not enough read
+     *         latencies are known yet.
+     */
+    auto hedgeDelay() -> std::optional<std::chrono::microseconds>;
+
+    /**
+     * Hedges the query if it is an idempotent replica read and hedging is enabled, its on
+     * complete callback moves to the hedged read and a duplicate is prepared.
+     * @param query_handle The query being started.
+     */
+    auto hedge(
+        QueryHandle& query_handle) -> void;
+
+    /**
+     * Registers an attempt of a hedged read that is about to execute, the original attempt's
+     * duplicate is scheduled to be sent once the hedge delay passes.  The attempt's connection is
+     * connected first so it can be killed if it loses.
+     * @param query The attempt.
+     */
+    auto startHedgeAttempt(
+        Query& query) -> void;
+
+    /**
+     * Unregisters an attempt of a hedged read once it has executed, before its connection is
+     * released so a late kill can't hit another query on the connection.
+     * @param query The attempt.
+     */
+    auto finishHedgeAttempt(
+        Query& query) -> void;
+
+    /**
+     * Records a successful replica read's latency, the hedge delay is periodically re-computed
+     * as the configured percentile of the recent latencies.
+     * @param latency How long the read took to execute.
+     */
+    auto recordReadLatency(
+        std::chrono::microseconds latency) -> void;
+
+    /**
+     * Background loop sending the duplicates of reads that are still executing once the hedge
+     * delay passes, and killing the losing attempts of finished reads.
+     */
+    auto hedger() -> void;
+
+    /**
+     * Sends a hedged read's duplicate to a replica the read isn't already executing on, if
+     * the read hasn't finished and there is such a replica.
+     * @param hedged_read The slow read.
+     */
+    auto sendHedge(
+        HedgedRead& hedged_read) -> void;
+
+    /**
+     * Kills the attempts of a finished hedged read that are still executing.
+     * @param hedged_read The finished read.
+     */
+    auto cancelHedge(
+        HedgedRead& hedged_read) -> void;
+
+    /**
+     * Hands a finished query to its on complete callback, if the query led a single flight then
+     * every query waiting on it receives the shared result as well.  Cacheable results are stored
+     * in the result cache first and writes invalidate the cached results of the tables they touch.
+     * @param query_handle The executed query.
+     */
+    auto complete(
+        QueryHandle query_handle) -> void;
 };
 
 } // namespace wing
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "wing/CircuitBreakerOptions.hpp"
+#include "wing/ConcurrencyLimitOptions.hpp"
+#include "wing/ConnectionInfo.hpp"
+#include "wing/HedgeOptions.hpp"
+#include "wing/QueryPoolOptions.hpp"
+#include "wing/RetryOptions.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace wing {
+
+/**
+ * How an Executor with several replicas picks the replica for a read.
+ */
+enum class ReplicaBalancing {
+    /// Reads are spread evenly across the replicas.
+    ROUND_ROBIN,
+    /// Power of two choices, two random replicas are compared and the read goes to the one with
+    /// the lower cost, its decaying peak latency average multiplied by its number of executing
+    /// queries plus one.  A slow replica quickly receives a small share of the reads.
+    LATENCY_AWARE
+};
+
+/**
+ * Executor wide tuning options.
+ */
+struct ExecutorOptions {
+    /// The maximum number of queued `QueryOptions::group_commit` writes a worker will coalesce
+    /// into a single transaction.  Only writes already waiting in the queue are coalesced, the
+    /// worker never delays a write to grow a batch.  A value of 0 or 1 disables group commit.
+    std::size_t group_commit_max_batch_size { 32 };
+    /// The approximate number of bytes of query results the Executor's result cache can hold
+    /// before evicting the least recently used results, see `QueryOptions::cache_ttl`.
+    /// A value of 0 disables the result cache.
+    std::size_t result_cache_max_bytes { 0 };
+    /// The number of connections each worker keeps for itself between queries, a worker re-uses
+    /// its own warm connections without locking the shared pool.  Cached connections stay with
+    /// the worker across short idles and are handed back to the shared pool once idle for the
+    /// pool's `idle_timeout`, or its `maintenance_interval` if unset, so the pool's maintenance
+    /// and the other workers can use them.  Connections are never cached while the pool is at
+    /// its `QueryPoolOptions::max_connections`.  A value of 0 disables the per worker caches.
+    std::size_t worker_connection_cache_size { 1 };
+    /// Shared nothing mode, every worker has its own queue and keeps its own cached connections
+    /// instead of handing them back to the shared pool when idle, idle workers ping their own
+    /// connections at the pool's `keepalive_interval`.  Queries are assigned to a worker by
+    /// `QueryOptions::shard_key` or round robin, so workers never contend with each other but a
+    /// busy worker's queue is not drained by idle workers.
+    bool shared_nothing { false };
+    /// The weights of the tenants queued queries are fairly shared between, see
+    /// `QueryOptions::tenant`.  A tenant with twice the weight of another is served twice as many
+    /// queries while both have queries waiting.  Tenants without a weight, or with a weight that
+    /// isn't positive, have a weight of 1.
+    std::unordered_map<std::string, double> tenant_weights {};
+    /// How reads are spread across the replicas.
+    ReplicaBalancing replica_balancing { ReplicaBalancing::LATENCY_AWARE };
+    /// How quickly a replica's latency average forgets old latencies, a slow latency is
+    /// remembered until it decays or faster latencies replace it.  The average of a replica
+    /// that receives no reads decays towards zero so it is eventually tried again.
+    std::chrono::milliseconds replica_latency_decay { 10000 };
+    /// How often every replica's replication lag is sampled in the background, queries with a
+    /// `QueryOptions::max_staleness` skip replicas that are too far behind.  A value of 0 disables
+    /// sampling and every replica's lag is unknown.
+    std::chrono::milliseconds replica_lag_interval { 0 };
+    /// The statement that samples a replica's lag, it must return the lag in seconds as the
+    /// first column of its first row, e.g. from a heartbeat table written by the primary.  If
+    /// empty `Seconds_Behind_Source` from `SHOW REPLICA STATUS` is used.
+    std::string replica_lag_statement {};
+    /// Enables `session_track_gtids = OWN_GTID` on the primary's connections, every write then
+    /// reports the GTID set it committed as its `Query::ConsistencyToken()`.  Requires GTID based
+    /// replication on the servers.
+    bool track_gtids { false };
+    /// How long a replica read with a `QueryOptions::consistency_token` waits for the replica to
+    /// apply the token's GTID set before it executes on the primary instead.
+    std::chrono::milliseconds consistency_wait { 50 };
+    /// A standby for the primary, writes and transactions fail over to the standby while the
+    /// primary is unhealthy and the standby is healthy, and fail back once the primary is
+    /// healthy again.
+    std::optional<ConnectionInfo> standby {};
+    /// The number of idle connections the standby's pool keeps connected so a failover doesn't
+    /// start with a cold pool.
+    std::size_t standby_min_idle { 2 };
+    /// The number of consecutive connect failures, lost connections or failed health probes
+    /// after which a server is unhealthy.  Reads route around unhealthy replicas and writes fail
+    /// over to a healthy standby.  A value of 0 never marks a server unhealthy.
+    std::size_t unhealthy_threshold { 3 };
+    /// How often every server is probed in the background when the Executor has replicas or a
+    /// standby, a successful probe makes an unhealthy server healthy again.  A value of 0
+    /// disables the probes, unhealthy servers then only recover through queries still routed to
+    /// them.
+    std::chrono::milliseconds health_check_interval { 1000 };
+    /// Automatic retries of queries that failed with a transient error, disabled by default.
+    RetryOptions retry {};
+    /// Hedged replica reads to cut tail latency, disabled by default.
+    HedgeOptions hedge {};
+    /// Every server's circuit breaker, disabled by default.
+    CircuitBreakerOptions circuit_breaker {};
+    /// Every server's adaptive concurrency limit, disabled by default.
+    ConcurrencyLimitOptions concurrency_limit {};
+    /// Sizing and connection lifetime options for the Executor's query pools, every server's
+    /// pool has the same options.
+    QueryPoolOptions query_pool {};
+};
+
+} // wing
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace wing {
+
+/**
+ * Hedged replica reads.  A replica read that is still executing after the configured percentile
+ * of recent read latencies is duplicated onto another replica, the first attempt to succeed
+ * completes the query and the other attempt is killed with `KILL QUERY`.  Only idempotent
+ * replica reads are hedged and only if the Executor has at least two replicas.
+ */
+struct HedgeOptions {
+    /// Reads still executing after this percentile of recent read latencies are hedged, e.g. 0.95
+    /// hedges roughly the slowest 5% of reads.  A value of 0 disables hedging.
+    double percentile { 0.0 };
+    /// The shortest delay before a read is hedged, so reads are not hedged on noise.
+    std::chrono::milliseconds min_delay { 2 };
+    /// The number of recent read latencies the percentile is computed over.  Reads are not hedged
+    /// until enough latencies have been seen for the percentile to be meaningful.
+    std::size_t window { 1000 };
+};
+
+} // wing
@@ -1,7 +1,9 @@
 #pragma once
 
-#include "wing/ConnectionInfo.hpp"
+#include "wing/Connection.hpp"
+#include "wing/QueryOptions.hpp"
 #include "wing/QueryStatus.hpp"
+#include "wing/ResultSet.hpp"
 #include "wing/Row.hpp"
 #include "wing/Statement.hpp"
 
@@ -11,6 +13,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <mysql/mysql.h>
@@ -20,11 +23,18 @@ namespace wing {
 class QueryPool;
 class QueryHandle;
 class Executor;
+class HedgedRead;
+class QueryQueue;
+class ResultCache;
+class TransactionSession;
 
 class Query {
     friend QueryPool;
     friend QueryHandle;
     friend Executor;
+    friend QueryQueue;
+    friend ResultCache;
+    friend TransactionSession;
 
 public:
     ~Query();
@@ -49,6 +59,12 @@ public:
      */
     auto Error() const -> std::optional<std::string>;
 
+    /**
+     * @return The MySQL client or server error number of the error, 0 if there is no error
+     *         or the error did not come from MySQL, e.g. an invalid statement.
+     */
+    auto ErrorNumber() const -> unsigned int { return m_error_number; }
+
     /**
      * @return Returns the error message, or the default_msg if there is no error.
      */
@@ -75,88 +91,179 @@ public:
     /**
      * @return The query result's rows.
      */
-    auto Rows() const -> const std::vector<wing::Row>& { return m_rows; }
+    auto Rows() const -> const std::vector<wing::Row>&;
+
+    /**
+     * @return True if the result was served from the Executor's result cache rather than
+     *         executed on the MySQL server.
+     */
+    auto FromCache() const -> bool { return m_from_cache; }
+
+    /**
+     * @return The GTID set of the write this query committed if the Executor tracks GTIDs, see
+     *         `ExecutorOptions::track_gtids`.  Pass it as `QueryOptions::consistency_token` to
+     *         reads that must observe this write.  Empty if the query committed nothing.
+     */
+    auto ConsistencyToken() const -> const std::string& { return m_consistency_token; }
+
+    /**
+     * @return The number of times this query was retried after a transient error, see
+     *         `ExecutorOptions::retry`.
+     */
+    auto RetryCount() const -> std::size_t { return m_retry_count; }
+
+    /**
+     * @return True if this result came from the hedged duplicate of a slow read, see
+     *         `ExecutorOptions::hedge`.
+     */
+    auto Hedged() const -> bool { return m_hedged; }
 
     /**
      * @return The last insert ID from this query.
      */
-    auto LastInsertId() -> uint64_t { return mysql_insert_id(&m_mysql); }
+    auto LastInsertId() -> uint64_t { return m_last_insert_id; }
 
 private:
     Query(
-        QueryPool& query_pool,
-        const ConnectionInfo& connection,
         std::function<void(QueryHandle)> on_complete,
         std::chrono::milliseconds timeout,
         wing::Statement statement);
 
     /**
-     * Resets QueryHandle, freeing results and clearing m_query_parts and m_bind_params
+     * Executes the query synchronously on the given connection, connecting it first if needed.
+     * The query blocks until it finishes or times out, the results are stored in the query so
+     * the connection can be returned to its pool as soon as this returns.
+     * @param connection The connection to execute on.
+     * @return The status of the query, e.g. success or timeout.
      */
-    auto reset() -> void;
+    auto execute(
+        Connection& connection) -> wing::QueryStatus;
 
     /**
-     * Internally sets the timeout for the query.
+     * Executes this query's statement on the given connected MySQL client, e.g. when writes
+     * are group committed on a single connection.  The results and any error are captured
+     * into this query.
+     * @param mysql The connected MySQL client to execute the statement on.
+     * @return The status of the query.
      */
-    auto timeout() -> void;
+    auto executeOn(
+        MYSQL& mysql) -> wing::QueryStatus;
 
     /**
-     * Executes the query synchronously.
-     *
-     * Note that synchronous/asynchronous queries cannot be mixed
-     * on an EventLoop.  If you are using an EventLoop you *MUST*
-     * use its QueryPool otherwise the Query will not know how to
-     * execute properly.
-     *
-     * In this mode the query does not require an EventLoop object,
-     * however it will block until it finishes or times out.
-     * @return The status of the query, e.g. success or timeout.
+     * Marks this query as failed.
+     * @param status The failure status.
+     * @param message The error message to report via Error().
+     * @param error_number The MySQL error number, if any.
+     */
+    auto setError(
+        wing::QueryStatus status,
+        std::string message,
+        unsigned int error_number = 0) -> void;
+
+    /**
+     * Marks this query as failed with the last error on the MySQL connection.
+     * @param status The failure status.
+     * @param mysql The MySQL connection that had the error.
+     */
+    auto setError(
+        wing::QueryStatus status,
+        MYSQL& mysql) -> void;
+
+    /**
+     * @return True if executing this query may leave state behind on the connection's session.
+     */
+    auto changesSession() const -> bool;
+
+    /**
+     * @return True if this query may be coalesced with other writes into a shared transaction.
+     */
+    auto isGroupCommitEligible() const -> bool;
+
+    /**
+     * @return True if this query may share the result of an identical in flight read, reads with
+     *         a consistency token or a max staleness never do.
+     */
+    auto isSingleFlightEligible() const -> bool;
+
+    /**
+     * @return True if this query's successful result may be stored in a result cache.
+     */
+    auto isCacheable() const -> bool;
+
+    /**
+     * @return True if this query may modify table data and so invalidates cached results.
+     */
+    auto isWrite() const -> bool { return m_statement.isWrite(); }
+
+    /**
+     * @return True if this query can safely execute more than once.
+     */
+    auto isIdempotent() const -> bool;
+
+    /**
+     * Clears the outcome of a failed attempt so the query can be executed again.
+     */
+    auto resetForRetry() -> void;
+
+    /**
+     * @return True if this query should execute on a replica, see `QueryOptions::route`.
+     */
+    auto isReplicaEligible() const -> bool;
+
+    /**
+     * @return The result cache tags for this query, the tables in its statement and any
+     *         user supplied tags, lower cased and sorted.
+     */
+    auto cacheTags() const -> std::vector<std::string>;
+
+    /**
+     * Normalizes a result cache tag the way tables are read from statements, lower cased and
+     * without a database qualifier, e.g. `DB.Users` becomes `users`.
+     * @param tag The table name or user supplied tag.
+     * @return The normalized tag.
      */
-    auto execute() -> wing::QueryStatus;
+    static auto normalizeCacheTag(
+        std::string tag) -> std::string;
 
     /**
-     * If the handle has not yet connected, this will block and connect.
-     *
-     * This function should only be run on the connect background thread
-     * for asynchronous queries.
-     *
-     * @return True on connected, false on failure.
+     * @return The key identifying this query's final statement, see Statement::key().
      */
-    auto connect() -> bool;
+    auto statementKey() const -> std::string { return m_statement.key(); }
 
     /**
-     * Parses the rows from the result.
+     * Copies the outcome of an executed query into this query, the result set itself is
+     * shared rather than copied.
+     * @param from The executed query to share the outcome of.
      */
-    auto parseRows() -> void;
+    auto shareResult(
+        const Query& from) -> void;
 
     /**
      * Frees the previous query result.
      */
     auto freeResult() -> void;
 
-    /// Every query must have a query pool.
-    QueryPool& m_query_pool;
-    /// Connection information for the MySQL server.
-    const ConnectionInfo& m_connection;
     /// On complete function handler for this query.
     std::function<void(QueryHandle)> m_on_complete;
 
     /// The timeout in milliseconds.
     std::chrono::milliseconds m_timeout;
-    mutable MYSQL m_mysql;
-    MYSQL_RES* m_result { nullptr };
-    /// True if the result has already been parsed (to avoid doing it multiple times).
-    bool m_parsed_result { false };
+    /// The connection this query executes on, only held while the query is queued or executing.
+    std::unique_ptr<Connection> m_connection { nullptr };
+    /// The stored result rows, possibly shared with other queries.
+    std::shared_ptr<const ResultSet> m_result_set;
     /// The number of fields returned from the query.
     size_t m_field_count { 0 };
     /// The number of rows returned from the query.
     size_t m_row_count { 0 };
-    /// User facing rows view.
-    std::vector<wing::Row> m_rows;
-    /// Has this MySQL client connected to the server yet?
-    bool m_is_connected { false };
     /// Has this MySQL client had an error?
     bool m_had_error { false };
+    /// The error message captured when the error occurred.
+    std::string m_error_message;
+    /// The MySQL error number captured when the error occurred.
+    unsigned int m_error_number { 0 };
+    /// The last insert ID captured after the statement executed.
+    uint64_t m_last_insert_id { 0 };
 
     /// The status of the last query.
     wing::QueryStatus m_query_status { QueryStatus::BUILDING };
@@ -164,6 +271,36 @@ private:
     wing::Statement m_statement;
     /// The SQL statement that was last executed
     std::string m_final_statement;
+    /// The execution hints for this query.
+    wing::QueryOptions m_options;
+    /// The statement key, only built for queries that are cached or single flight.
+    std::string m_statement_key;
+    /// Does this query lead a single flight that other queries are waiting on?
+    bool m_leads_single_flight { false };
+    /// Was this query served from a result cache?
+    bool m_from_cache { false };
+    /// The result cache's invalidation epoch when this query was started.
+    uint64_t m_cache_epoch { 0 };
+    /// Is this query registered with the result cache as an in flight read?
+    bool m_cache_reading { false };
+    /// The index of the Executor queue this query was assigned to.
+    std::size_t m_queue_index { 0 };
+    /// The number of times this query was retried.
+    std::size_t m_retry_count { 0 };
+    /// The GTID set this query committed, if tracked.
+    std::string m_consistency_token {};
+    /// The pool of the server this query executes on, chosen by the Executor when it is started.
+    QueryPool* m_target_pool { nullptr };
+    /// The pool whose concurrency limit admitted this query while it was parked.
+    QueryPool* m_limit_pool { nullptr };
+    /// The hedged read this query is an attempt of, if any.
+    std::shared_ptr<HedgedRead> m_hedge { nullptr };
+    /// Is this query the hedged duplicate of a slow read?
+    bool m_hedged { false };
+    /// The id of this query's executing attempt of its hedged read.
+    uint64_t m_hedge_attempt_id { 0 };
+    /// The transaction this query executes in, if any.
+    std::shared_ptr<TransactionSession> m_session { nullptr };
 };
 
 } // wing
@@ -7,9 +7,8 @@
 namespace wing {
 
 /**
- * This proxy object is used to modify the SQL query and
- * guarantee that the underlying object will always be returned
- * to the QueryPool for re-use.
+ * This proxy object owns a query and its results, the connection the query executed on
+ * has already been returned to the QueryPool by the time the handle is given to the user.
  */
 class QueryHandle {
     friend class QueryPool;
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace wing {
+
+/**
+ * Where an Executor with replicas sends a query.
+ */
+enum class QueryRoute {
+    /// Plain SELECTs go to a replica, everything else goes to the primary.  SELECTs that lock
+    /// rows or may change the session, e.g. FOR UPDATE, GET_LOCK() or user variables, go to
+    /// the primary.
+    AUTO,
+    /// Always execute on the primary, e.g. a read that must see the caller's own writes.
+    PRIMARY,
+    /// Execute on a replica, the caller knows the statement is safe to run there.
+    REPLICA
+};
+
+/**
+ * Per query execution hints, the defaults execute the query exactly as written on
+ * its own pooled connection.
+ */
+struct QueryOptions {
+    /// This query is an independent INSERT, UPDATE, DELETE or REPLACE that the Executor may
+    /// coalesce with other queued group commit writes into a single BEGIN ... COMMIT on one
+    /// connection.  Each query still receives its own result, if the shared transaction fails
+    /// the writes are rolled back and executed individually instead.
+    bool group_commit { false };
+    /// This query is a SELECT without side effects, if an identical statement is already in flight
+    /// on the Executor this query waits for and shares its result instead of executing again.
+    /// Reads with a `consistency_token` or `max_staleness` always execute on their own.
+    bool single_flight { false };
+    /// If greater than zero and the Executor has a result cache, this SELECT's successful result
+    /// is cached for this long and identical queries with a cache ttl are served from the cache
+    /// without a round trip to the MySQL server.
+    std::chrono::milliseconds cache_ttl { 0 };
+    /// Extra result cache tags for this query on top of the tables found in its statement, e.g.
+    /// the tables behind a view.  A cached read is invalidated when a write with a shared tag
+    /// completes on the same Executor.
+    std::vector<std::string> cache_tags {};
+    /// With `ExecutorOptions::shared_nothing` queries with the same non empty shard key always
+    /// execute on the same worker, in the order they were started if they share a tenant.
+    /// Queries without a shard key are assigned to workers round robin.
+    std::string shard_key {};
+    /// The tenant this query is queued for, queued queries are served across tenants by weighted
+    /// fair queuing so one tenant queuing a flood of queries can't delay every other tenant's
+    /// queries, see `ExecutorOptions::tenant_weights`.  A tenant's queries are served in the
+    /// order they were started.  Queries without a tenant and transactions share one tenant.
+    std::string tenant {};
+    /// Read/write routing hint for an Executor with replicas, without replicas every query
+    /// executes on the primary.
+    QueryRoute route { QueryRoute::AUTO };
+    /// If greater than zero a replica read only executes on a replica whose sampled replication
+    /// lag is known and within this bound, see `ExecutorOptions::replica_lag_interval`.  If no
+    /// replica is fresh enough the read executes on the primary.
+    std::chrono::milliseconds max_staleness { 0 };
+    /// The `Query::ConsistencyToken()` of a write this read must observe, tokens of several writes
+    /// can be joined with a ','.  A replica read first waits up to the Executor's
+    /// `consistency_wait` for the replica to apply the write, then executes on the primary if it
+    /// hasn't.
+    std::string consistency_token {};
+    /// This write can safely execute more than once, it may be retried after a lost connection
+    /// when the Executor retries transient errors.  Statements that don't modify data are always
+    /// idempotent.
+    bool idempotent { false };
+};
+
+} // wing
@@ -1,22 +1,50 @@
 #pragma once
 
+#include "wing/CircuitBreakerOptions.hpp"
+#include "wing/ConcurrencyLimitOptions.hpp"
+#include "wing/Connection.hpp"
 #include "wing/ConnectionInfo.hpp"
 #include "wing/Query.hpp"
 #include "wing/QueryHandle.hpp"
+#include "wing/QueryPoolOptions.hpp"
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace wing {
 
+/**
+ * The state of a server's circuit breaker.
+ */
+enum class CircuitState {
+    /// Queries execute normally.
+    CLOSED,
+    /// Queries fail fast until the cool down has passed.
+    OPEN,
+    /// A limited number of probe queries execute to test the server.
+    HALF_OPEN
+};
+
 class Executor;
+class TransactionSession;
 
+/**
+ * Produces queries and pools the connections they execute on.
+ */
 class QueryPool {
     friend Executor;
-    friend QueryHandle;
+    friend wing::Connection;
+    friend TransactionSession;
 
 public:
     ~QueryPool();
@@ -32,7 +60,12 @@ public:
     auto Connection() const -> const ConnectionInfo& { return m_connection; }
 
     /**
-     * Produces a Query from the pool with the provided query and timeout.
+     * @return The sizing and lifetime options for this pool.
+     */
+    auto Options() const -> const QueryPoolOptions& { return m_options; }
+
+    /**
+     * Produces a Query with the provided query and timeout.
      * @param statement The SQL statement, can contain bind parameters.
      * @param timeout The timeout for this query in milliseconds.
      * @return A Query handle.
@@ -42,7 +75,7 @@ public:
         std::chrono::milliseconds timeout) -> QueryHandle;
 
     /**
-     * Produces a Query from the pool with the provided query, timeout and on complete callback.
+     * Produces a Query with the provided query, timeout and on complete callback.
      * @param statement The SQL statement, can contain bind parameters.
      * @param timeout The timeout for this query in milliseconds.
      * @param on_complete Completion callback.
@@ -53,36 +86,424 @@ public:
         std::chrono::milliseconds timeout,
         std::function<void(QueryHandle)> on_complete) -> QueryHandle;
 
+    /**
+     * @return The number of idle connections in the pool.
+     */
     auto size() -> std::size_t
     {
         std::lock_guard<std::mutex> guard { m_lock };
-        return m_queries.size();
+        return m_connections.size();
     }
 
-    auto clear() -> void
+    /**
+     * @return The number of connections this pool has open, idle or checked out.
+     */
+    auto total() -> std::size_t
     {
         std::lock_guard<std::mutex> guard { m_lock };
-        m_queries.clear();
+        return m_total;
+    }
+
+    /**
+     * Closes all idle connections.
+     */
+    auto clear() -> void;
+
+    /**
+     * @return The number of queries currently executing on this pool's server, this is only
+     *         tracked while the Executor balances reads across replicas.
+     */
+    auto ExecutingQueryCount() const -> uint64_t { return m_executing.load(std::memory_order_relaxed); }
+
+    /**
+     * @return False if this pool's server failed too many consecutive queries or health probes,
+     *         the Executor routes around unhealthy servers when it can.
+     */
+    auto Healthy() const -> bool { return m_healthy.load(std::memory_order_relaxed); }
+
+    /**
+     * @return The state of this pool's server's circuit breaker.
+     */
+    auto Circuit() -> CircuitState
+    {
+        std::lock_guard<std::mutex> guard { m_stats_lock };
+        return m_circuit_state;
+    }
+
+    /**
+     * @return The current adaptive concurrency limit of this pool's server, 0 if the Executor
+     *         doesn't limit it.
+     */
+    auto ConcurrencyLimit() -> std::size_t
+    {
+        std::lock_guard<std::mutex> guard { m_stats_lock };
+        return static_cast<std::size_t>(m_limit);
     }
 
 private:
     std::mutex m_lock;
+    /// Signaled when a connection is returned or closed while the pool is at max connections.
+    std::condition_variable m_wait_cv;
     ConnectionInfo m_connection;
-    std::deque<std::unique_ptr<Query>> m_queries;
+    QueryPoolOptions m_options;
+    /// Executed on every new connection and after every session reset, empty if none.
+    std::string m_session_init;
+    /// Idle connections, the most recently returned connection is at the back.
+    std::deque<std::unique_ptr<wing::Connection>> m_connections;
+    /// The number of connections alive that were created by this pool, only modified while
+    /// holding the lock but can be read without it.
+    std::atomic<std::size_t> m_total { 0 };
+
+    /// Signaled when a connect slot is freed.
+    std::condition_variable m_connect_cv;
+    /// The number of connection attempts in progress.
+    std::size_t m_connecting { 0 };
+    /// The number of consecutive failed connection attempts.
+    std::size_t m_connect_failures { 0 };
+    /// Connection attempts fail without contacting the server until this time.
+    std::chrono::steady_clock::time_point m_connect_backoff_until {};
+    /// Jitters the connect backoff so clients don't retry in lockstep.
+    std::minstd_rand m_random { std::random_device {}() };
+
+    /// Signaled when a background connector is requested to make a new connection.
+    std::condition_variable m_connector_cv;
+    /// The number of requested background connects that no connector has started yet.
+    std::size_t m_connect_requests { 0 };
+    /// The number of background connects in progress.
+    std::size_t m_background_connecting { 0 };
+    /// The number of workers waiting in acquire() for a background connect.
+    std::size_t m_acquirers_waiting { 0 };
+    /// Connections whose background connect failed, handed to a waiting worker so its query
+    /// reports the connect error.
+    std::deque<std::unique_ptr<wing::Connection>> m_failed_connections;
+    std::vector<std::thread> m_connector_threads;
+
+    /// The number of queries executing on this pool's server.
+    std::atomic<uint64_t> m_executing { 0 };
+    /// The number of consecutive failed queries or health probes on this pool's server.
+    std::atomic<std::size_t> m_consecutive_failures { 0 };
+    /// Is this pool's server healthy?
+    std::atomic<bool> m_healthy { true };
+    /// Guards the latency average and the replication lag.
+    std::mutex m_stats_lock;
+    /// Decaying peak average of the query latencies on this pool's server in microseconds.
+    double m_latency_average { 0.0 };
+    /// When the latency average was last updated.
+    std::chrono::steady_clock::time_point m_latency_updated_at {};
+    /// The circuit breaker's state.
+    CircuitState m_circuit_state { CircuitState::CLOSED };
+    /// When the circuit breaker last opened.
+    std::chrono::steady_clock::time_point m_circuit_opened_at {};
+    /// When the circuit breaker last half opened.
+    std::chrono::steady_clock::time_point m_circuit_half_opened_at {};
+    /// When the circuit breaker's current failure counting window started.
+    std::chrono::steady_clock::time_point m_circuit_window_start {};
+    /// The number of queries and failed queries within the current window.
+    std::size_t m_circuit_window_queries { 0 };
+    std::size_t m_circuit_window_failures { 0 };
+    /// The number of probe queries let through and succeeded since the breaker half opened.
+    std::size_t m_circuit_probes_admitted { 0 };
+    std::size_t m_circuit_probes_succeeded { 0 };
+    /// The adaptive concurrency limit, 0 until the first query is admitted.
+    double m_limit { 0.0 };
+    /// The number of queries admitted by the concurrency limit that haven't finished.
+    std::size_t m_limit_admitted { 0 };
+    /// Slowly moving average of the query latencies in microseconds, the latency tolerance is
+    /// relative to it.
+    double m_limit_latency_average { 0.0 };
+    /// Queries waiting for a concurrency limit slot with when they were parked, oldest first.
+    std::deque<std::pair<std::chrono::steady_clock::time_point, QueryHandle>> m_limit_parked {};
+    /// The last sampled replication lag of this pool's server, nullopt if it is unknown.
+    std::optional<std::chrono::milliseconds> m_replication_lag {};
+    /// When the replication lag was sampled.
+    std::chrono::steady_clock::time_point m_replication_lag_sampled_at {};
+
+    /// Stops the background maintenance and connector threads.
+    std::atomic<bool> m_stop { false };
+    std::condition_variable m_maintenance_cv;
+    std::optional<std::thread> m_maintenance_thread;
 
     /**
-     * Creates a query pool for running synchronous requests.
-     * Queries created from this pool *CANNOT* be used in an EventLoop.
-     *
+     * Creates a pool of connections to the MySQL server.
      * @param connection The MySQL Server connection information.
+     * @param options Sizing and lifetime options.
+     * @param session_init A statement that prepares the session of every connection, e.g.
+     *                     enabling session tracking, it is executed again after a reset.
      */
     explicit QueryPool(
-        ConnectionInfo connection);
+        ConnectionInfo connection,
+        QueryPoolOptions options = QueryPoolOptions {},
+        std::string session_init = {});
+
+    /**
+     * Checks out an idle connection, or creates a new unconnected connection if there are none.
+     * If the pool is at its max connections this blocks for up to the max wait.  With background
+     * connectors this instead blocks until a connection is ready or a background connect failed.
+     * @return A connection, or nullptr if none was available within the max wait.
+     */
+    auto acquire() -> std::unique_ptr<wing::Connection>;
+
+    /**
+     * acquire() with background connectors, new connections are requested from the connectors
+     * rather than connected by the caller.
+     * @param lock The held pool lock.
+     * @return A connected connection, a connection whose connect failed, or nullptr if none
+     *         was available within the max wait.
+     */
+    auto acquireBackground(
+        std::unique_lock<std::mutex>& lock) -> std::unique_ptr<wing::Connection>;
+
+    /**
+     * Returns a checked out connection to the pool, broken or expired connections and
+     * connections that fail to reset are closed instead.
+     * @param connection The connection to return.
+     */
+    auto release(
+        std::unique_ptr<wing::Connection> connection) -> void;
+
+    /**
+     * Prepares a checked out connection for re-use without touching the pool's shared state.
+     * @param connection The connection being returned.
+     * @return False if the connection is broken, expired or failed to reset and must be closed.
+     */
+    auto recycle(
+        wing::Connection& connection) -> bool;
+
+    /**
+     * Adds a recycled connection to the idle connections.
+     * @param connection The recycled connection.
+     */
+    auto store(
+        std::unique_ptr<wing::Connection> connection) -> void;
+
+    /**
+     * A lock free check if the pool can't open any more connections, connections held outside
+     * of the pool should be returned to it so other threads can use them.
+     * @return True if the pool has as many connections open as it is allowed.
+     */
+    auto atCapacity() const -> bool
+    {
+        return m_options.max_connections > 0 && m_total.load(std::memory_order_relaxed) >= m_options.max_connections;
+    }
+
+    /**
+     * Creates a connection to this pool's server for background control statements, e.g.
+     * replication lag samples.  It is not counted by the pool and must never be returned to it.
+     * @return The unconnected control connection.
+     */
+    auto controlConnection() -> std::unique_ptr<wing::Connection>;
+
+    /**
+     * Called by a connection created from this pool when it is destroyed.
+     */
+    auto connectionDestroyed() -> void;
+
+    /**
+     * Called before a connection attempt, waits for a free connect slot if the number of
+     * concurrent connects is limited.
+     * @return False if the pool is backing off after connect failures and the attempt must not
+     *         be made.
+     */
+    auto beginConnect() -> bool;
+
+    /**
+     * Called after a connection attempt started with beginConnect(), frees its connect slot and
+     * starts or resets the backoff.
+     * @param connected True if the attempt succeeded.
+     */
+    auto endConnect(
+        bool connected) -> void;
+
+    /**
+     * @return True if the connection has been connected longer than the max lifetime.
+     */
+    auto expired(
+        const wing::Connection& connection,
+        std::chrono::steady_clock::time_point now) const -> bool;
+
+    /**
+     * Background maintenance loop, closes idle connections past their idle timeout or max
+     * lifetime, pings idle connections to keep them alive and connects new idle connections
+     * up to the min idle or to replace dead connections.
+     */
+    auto maintenance() -> void;
+
+    /**
+     * Adds a query's latency to the server's latency average, a latency above the average
+     * replaces it right away while lower latencies are blended in as the average decays.
+     * @param latency How long the query took, failed queries report a penalty latency.
+     * @param decay How quickly the average forgets older latencies.
+     */
+    auto recordLatency(
+        std::chrono::microseconds latency,
+        std::chrono::milliseconds decay) -> void;
+
+    /**
+     * The cost of sending another query to this pool's server, its decayed latency average
+     * multiplied by the number of executing queries plus one.
+     * @param decay How quickly the average forgets older latencies.
+     * @return The cost, lower is better.
+     */
+    auto loadCost(
+        std::chrono::milliseconds decay) -> double;
+
+    /**
+     * Records the outcome of a query or health probe on this pool's server, a success makes the
+     * server healthy and enough consecutive failures make it unhealthy.
+     * @param succeeded False if the server couldn't be reached or the connection was lost.
+     * @param unhealthy_threshold The number of consecutive failures that make the server
+     *                            unhealthy, 0 never marks it unhealthy.
+     */
+    auto recordHealth(
+        bool succeeded,
+        std::size_t unhealthy_threshold) -> void;
 
-    auto returnQuery(
-        std::unique_ptr<Query> query_handle_ptr) -> void;
+    /**
+     * Asks the circuit breaker if a new query may execute on this pool's server, an open breaker
+     * half opens once its cool down has passed and then admits a limited number of probes.
+     * @param options The circuit breaker options.
+     * @return True if the query may execute, every admitted query must call recordCircuit() or
+     *         circuitRelease().
+     */
+    auto circuitAdmit(
+        const CircuitBreakerOptions& options) -> bool;
+
+    /**
+     * Gives back the probe slot of an admitted query that never reached the server, e.g. it was
+     * shed or ran out of pooled connections.
+     * @param options The circuit breaker options.
+     */
+    auto circuitRelease(
+        const CircuitBreakerOptions& options) -> void;
+
+    /**
+     * @param options The circuit breaker options.
+     * @return True if the circuit breaker is open and still cooling down, this doesn't admit a
+     *         probe.
+     */
+    auto circuitOpen(
+        const CircuitBreakerOptions& options) -> bool;
 
-    auto close() -> void;
+    /**
+     * Records the outcome of a query on this pool's server with the circuit breaker.
+     * @param succeeded False if the query failed to connect, lost its connection or timed out.
+     * @param admitted True if circuitAdmit() admitted the query, the outcome of a query that
+     *                 wasn't admitted only counts while the breaker is closed.
+     * @param options The circuit breaker options.
+     */
+    auto recordCircuit(
+        bool succeeded,
+        bool admitted,
+        const CircuitBreakerOptions& options) -> void;
+
+    /// The outcome of asking the concurrency limit to admit a query.
+    enum class LimitAdmit {
+        /// The query may execute, it must call recordLimit() or limitRelease() once done.
+        ADMITTED,
+        /// The query was taken by the pool until a slot frees up.
+        PARKED,
+        /// The server is at its limit and the query may not wait.
+        SHED
+    };
+
+    /**
+     * Admits a query if this pool's server is below its concurrency limit, otherwise the query
+     * is parked on the pool without holding up the worker.  A parked query is handed back
+     * admitted once a slot frees up, or failed with OVERLOADED once it has waited the max wait.
+     * @param query_handle The query, moved into the pool if it is parked.
+     * @param options The concurrency limit options.
+     */
+    auto limitAdmit(
+        QueryHandle& query_handle,
+        const ConcurrencyLimitOptions& options) -> LimitAdmit;
+
+    /**
+     * Releases an admitted query and adapts the concurrency limit to its outcome.
+     * @param latency How long the query took.
+     * @param overloaded True if the query couldn't reach the server or lost its connection.
+     * @param options The concurrency limit options.
+     * @return The parked queries to queue again, admitted or shed.
+     */
+    [[nodiscard]] auto recordLimit(
+        std::chrono::microseconds latency,
+        bool overloaded,
+        const ConcurrencyLimitOptions& options) -> std::vector<QueryHandle>;
+
+    /**
+     * Releases an admitted query that never reached the server without adapting the limit.
+     * @param options The concurrency limit options.
+     * @return The parked queries to queue again, admitted or shed.
+     */
+    [[nodiscard]] auto limitRelease(
+        const ConcurrencyLimitOptions& options) -> std::vector<QueryHandle>;
+
+    /**
+     * Hands the freed slots to the longest parked queries and sheds the parked queries past the
+     * max wait, the stats lock must be held.
+     * @param options The concurrency limit options.
+     * @return The parked queries to queue again.
+     */
+    auto limitResume(
+        const ConcurrencyLimitOptions& options) -> std::vector<QueryHandle>;
+
+    /**
+     * Sheds the parked queries past the max wait, the stats lock must be held.
+     * @param options The concurrency limit options.
+     * @param shed The shed queries are appended to it.
+     */
+    auto limitShed(
+        const ConcurrencyLimitOptions& options,
+        std::vector<QueryHandle>& shed) -> void;
+
+    /**
+     * Sheds the parked queries past the max wait even if no slot frees up.
+     * @param options The concurrency limit options.
+     * @param next_deadline Lowered to when the longest parked query left is shed, if any.
+     * @return The shed queries to queue again.
+     */
+    [[nodiscard]] auto limitExpire(
+        const ConcurrencyLimitOptions& options,
+        std::chrono::steady_clock::time_point& next_deadline) -> std::vector<QueryHandle>;
+
+    /**
+     * Sheds every parked query, they would never be resumed once the Executor has stopped.
+     * @return The shed queries.
+     */
+    [[nodiscard]] auto limitDrain() -> std::vector<QueryHandle>;
+
+    /**
+     * Actively checks this pool's server by connecting, or pinging an idle connection.
+     * @return True if the server responded, nullopt if no connection was available to probe with.
+     */
+    auto probe() -> std::optional<bool>;
+
+    /**
+     * Records a replication lag sample for this pool's server.
+     * @param lag The sampled lag, nullopt if it could not be determined.
+     */
+    auto replicationLag(
+        std::optional<std::chrono::milliseconds> lag) -> void;
+
+    /**
+     * How stale this pool's server may be, its last sampled replication lag plus the time
+     * since the sample was taken.
+     * @param now The current time.
+     * @return The staleness, or nullopt if the replication lag is unknown.
+     */
+    auto staleness(
+        std::chrono::steady_clock::time_point now) -> std::optional<std::chrono::milliseconds>;
+
+    /**
+     * Background connector loop, connects a new connection for every requested connect.
+     */
+    auto connector() -> void;
+
+    /**
+     * Pings the idle connections that haven't been used or pinged within the keepalive interval,
+     * dead connections are closed.
+     * @return The number of dead connections that were closed.
+     */
+    auto keepalive() -> std::size_t;
 };
 
 } // wing
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace wing {
+
+/**
+ * When a connection returned to the pool is reset with `mysql_reset_connection()`, a reset
+ * rolls back any open transaction, drops temporary tables, releases locks and restores the
+ * session variables in a single round trip without reconnecting.
+ */
+enum class ConnectionResetPolicy {
+    /// Connections are never reset.
+    NEVER,
+    /// Connections are reset if a statement that may have changed the session was executed on
+    /// them, see `Statement::changesSession()`, or their transaction failed.
+    ON_SESSION_CHANGE,
+    /// Connections are reset every time they are returned to the pool.
+    ALWAYS
+};
+
+/**
+ * Sizing and connection lifetime options for a QueryPool, the defaults match an unbounded
+ * pool whose connections live forever.
+ */
+struct QueryPoolOptions {
+    /// The maximum number of connections the pool will have open at once, idle, executing a
+    /// query or pinned to a transaction.  A value of 0 is unbounded.
+    std::size_t max_connections { 0 };
+    /// How long a worker waits for a connection to be returned once the pool is at
+    /// `max_connections`, after which the query completes with a CONNECT_FAILURE.  A value of 0
+    /// fails immediately.
+    std::chrono::milliseconds max_wait { 0 };
+    /// The number of idle connections the pool keeps connected and ready, new connections are
+    /// made in the background.
+    std::size_t min_idle { 0 };
+    /// Idle connections beyond `min_idle` are closed once they have been idle this long.  A value
+    /// of 0 never closes idle connections.
+    std::chrono::milliseconds idle_timeout { 0 };
+    /// Connections are closed once they have been connected this long, either when they are
+    /// returned to the pool or while idle.  A value of 0 never expires connections.
+    std::chrono::milliseconds max_lifetime { 0 };
+    /// Idle connections that haven't been used or pinged for this long are pinged in the
+    /// background so the server's `wait_timeout` or a middlebox doesn't silently drop them, dead
+    /// connections are replaced with new connections.  A value of 0 disables the keepalive.
+    std::chrono::milliseconds keepalive_interval { 0 };
+    /// The maximum number of connection attempts the pool makes at once, further attempts wait
+    /// for an attempt to finish.  This keeps a restarted server from being flooded with
+    /// handshakes when every connection reconnects at once.  A value of 0 is unbounded.
+    std::size_t max_concurrent_connects { 0 };
+    /// After a failed connection attempt no further attempts are made for this long, doubling
+    /// with each consecutive failure up to `connect_backoff_max` and jittered between half and
+    /// the full delay.  Queries that need a new connection during the backoff fail with a
+    /// CONNECT_FAILURE without contacting the server.  A value of 0 disables the backoff.
+    std::chrono::milliseconds connect_backoff_initial { 0 };
+    /// The longest connect backoff after repeated failures.
+    std::chrono::milliseconds connect_backoff_max { 10000 };
+    /// The number of background connector threads, when set workers never connect inline.  A
+    /// worker that needs a connection requests one from the connectors and takes the first
+    /// connection that becomes ready, either a newly connected one or one returned by another
+    /// worker, so a slow handshake doesn't hold up a worker that could be executing queries.  A
+    /// value of 0 connects on the worker that needs the connection.
+    std::size_t background_connectors { 0 };
+    /// When returned connections are reset to a clean session, connections that fail to reset
+    /// are closed.
+    ConnectionResetPolicy reset_policy { ConnectionResetPolicy::ON_SESSION_CHANGE };
+    /// How often the background maintenance checks the idle connections, maintenance only runs
+    /// if `min_idle`, `keepalive_interval`, `idle_timeout` or `max_lifetime` are set.
+    std::chrono::milliseconds maintenance_interval { 1000 };
+};
+
+} // wing
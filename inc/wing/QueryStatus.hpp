@@ -25,6 +25,10 @@ enum class QueryStatus {
     TIMEOUT,
     /// The MySQL server disconnected.
     DISCONNECT,
+    /// The server's circuit breaker is open after repeated failures, the query was not executed.
+    CIRCUIT_OPEN,
+    /// The server's adaptive concurrency limit was reached, the query was shed without executing.
+    OVERLOADED,
     /// Generic error, check the error string for more information.
     ERROR
 };
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "wing/ResultSet.hpp"
+
+#include <chrono>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace wing {
+
+class Executor;
+class Query;
+
+/**
+ * A thread safe read through cache of immutable query results keyed by statement.  Entries
+ * expire after their time to live and the least recently used entries are evicted once the
+ * cached results exceed the configured number of bytes.
+ *
+ * Entries are tagged with the tables their statement reads, when a write completes through
+ * the Executor every entry sharing a tag with the write is invalidated.  A read that was in
+ * flight while one of its tags was invalidated is not cached since it may have read the data
+ * from before the write.  A transaction's writes invalidate once it commits or rolls back.
+ * Writes made outside of the Executor are only bounded by the TTL.
+ */
+class ResultCache {
+    friend Executor;
+
+public:
+    ~ResultCache() = default;
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache(ResultCache&&) = delete;
+    auto operator=(const ResultCache&) noexcept -> ResultCache& = delete;
+    auto operator=(ResultCache&&) noexcept -> ResultCache& = delete;
+
+    /**
+     * @return The number of cached results, this can include expired results that have not
+     *         been evicted yet.
+     */
+    auto size() -> std::size_t;
+
+    /**
+     * @return The approximate number of bytes the cached results are using.
+     */
+    auto bytes() -> std::size_t;
+
+    /**
+     * Evicts every cached result.
+     */
+    auto clear() -> void;
+
+    /**
+     * Evicts every cached result tagged with the table, use this when the table is modified
+     * outside of the Executor.
+     * @param tag The table name or user supplied tag, see `QueryOptions::cache_tags`.  Tags are
+     *            case insensitive and a database qualifier is ignored, `DB.Users` matches `users`.
+     */
+    auto invalidate(
+        const std::string& tag) -> void;
+
+private:
+    struct Entry {
+        /// The statement key, the lookup table's keys view this string.
+        std::string m_key;
+        /// The cached rows, shared with every query that is served this entry.
+        std::shared_ptr<const ResultSet> m_result_set;
+        /// The final statement that produced the cached rows.
+        std::string m_final_statement;
+        /// When this entry can no longer be served.
+        std::chrono::steady_clock::time_point m_expires_at;
+        /// The approximate size of this entry.
+        std::size_t m_bytes;
+        /// The tables and user tags this entry was read from.
+        std::vector<std::string> m_tags;
+    };
+
+    struct Tag {
+        /// The epoch this tag was last invalidated at.
+        uint64_t m_invalidated_epoch { 0 };
+        /// The keys of the entries with this tag, these view the entries' keys.
+        std::unordered_set<std::string_view> m_keys {};
+    };
+
+    /**
+     * @param max_bytes The maximum approximate number of bytes to cache.
+     */
+    explicit ResultCache(
+        std::size_t max_bytes);
+
+    /**
+     * Serves the cached result for the key into the query if it exists and hasn't expired.
+     * @param key The statement key.
+     * @param query The query to serve the cached result into.
+     * @return True if the query was served from the cache.
+     */
+    auto find(
+        const std::string& key,
+        Query& query) -> bool;
+
+    /**
+     * Registers a cacheable read that is starting, every call must be paired with endRead().
+     * @return The current invalidation epoch, reads record this when they start so a result
+     *         that raced with an invalidation of one of its tags is not cached.
+     */
+    auto beginRead() -> uint64_t;
+
+    /**
+     * Unregisters a cacheable read once it has completed, after its result has been inserted.
+     * @param epoch The epoch returned by beginRead().
+     */
+    auto endRead(
+        uint64_t epoch) -> void;
+
+    /**
+     * Caches a successfully executed read's result for its `QueryOptions::cache_ttl` unless
+     * one of its tags has been invalidated since the read started.
+     * @param query The executed read.
+     */
+    auto insert(
+        const Query& query) -> void;
+
+    /**
+     * Invalidates every entry sharing a tag with the completed write, a write without any
+     * tags could have modified anything and clears the entire cache.
+     * @param query The completed write.
+     */
+    auto invalidate(
+        const Query& query) -> void;
+
+    /**
+     * Invalidates every entry sharing one of the tags, no tags clears the entire cache.
+     * @param tags The normalized tags written to.
+     */
+    auto invalidateTags(
+        const std::vector<std::string>& tags) -> void;
+
+    /**
+     * Invalidates a single tag, the lock must be held.
+     */
+    auto invalidateTag(
+        const std::string& tag) -> void;
+
+    /**
+     * Forgets tags without entries that were invalidated before every in flight read started,
+     * no in flight read can be rejected by them anymore.  The lock must be held.
+     */
+    auto pruneTags() -> void;
+
+    /**
+     * Records a tag that has no entries left so it can be pruned, the lock must be held.
+     */
+    auto idleTag(
+        const std::string& tag,
+        const Tag& tag_state) -> void;
+
+    /**
+     * Evicts every entry, the lock must be held.
+     */
+    auto evictAll() -> void;
+
+    /**
+     * Evicts a single entry, the lock must be held.
+     */
+    auto evict(
+        std::list<Entry>::iterator entry) -> void;
+
+    std::mutex m_lock;
+    std::size_t m_max_bytes;
+    std::size_t m_bytes { 0 };
+    /// Entries ordered from most to least recently used.
+    std::list<Entry> m_lru;
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> m_entries;
+    /// Every tag with entries, or invalidated since an in flight read started.
+    std::unordered_map<std::string, Tag> m_tags;
+    /// Tags that had no entries left by the epoch they were invalidated at, pruned once no in
+    /// flight read started before that epoch.  May hold tags that have entries again.
+    std::multimap<uint64_t, std::string> m_idle_tags;
+    /// The epochs of the in flight cacheable reads.
+    std::multiset<uint64_t> m_reading;
+    /// Increases on every invalidation.
+    uint64_t m_epoch { 0 };
+    /// The epoch the entire cache was last cleared at.
+    uint64_t m_cleared_epoch { 0 };
+};
+
+} // wing
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "wing/Row.hpp"
+
+#include <vector>
+
+#include <mysql/mysql.h>
+
+namespace wing {
+
+class Query;
+
+/**
+ * The immutable rows stored from a query's result.  A result set can be shared by
+ * several queries, e.g. when identical concurrent reads are deduplicated, the rows
+ * remain valid for as long as any query still references the result set.
+ */
+class ResultSet {
+    friend Query;
+
+public:
+    ~ResultSet();
+
+    ResultSet(const ResultSet&) = delete;
+    ResultSet(ResultSet&&) = delete;
+    auto operator=(const ResultSet&) noexcept -> ResultSet& = delete;
+    auto operator=(ResultSet&&) noexcept -> ResultSet& = delete;
+
+    /**
+     * @return The number of fields in the result.
+     */
+    auto FieldCount() const -> size_t { return m_field_count; }
+
+    /**
+     * @return The number of rows in the result.
+     */
+    auto RowCount() const -> size_t { return m_rows.size(); }
+
+    /**
+     * @return The result's rows.
+     */
+    auto Rows() const -> const std::vector<wing::Row>& { return m_rows; }
+
+    /**
+     * @return The approximate number of bytes of memory the result is using.
+     */
+    auto ByteSize() const -> size_t { return m_byte_size; }
+
+private:
+    /**
+     * Takes ownership of the stored result and parses all of its rows.
+     * @param result The stored MySQL result, freed when the result set is destroyed.
+     */
+    explicit ResultSet(
+        MYSQL_RES* result);
+
+    /// The stored MySQL result, owns the memory the row values view.
+    MYSQL_RES* m_result { nullptr };
+    /// The number of fields in the result.
+    size_t m_field_count { 0 };
+    /// User facing rows view.
+    std::vector<wing::Row> m_rows;
+    /// The approximate number of bytes of memory the result is using.
+    size_t m_byte_size { sizeof(ResultSet) };
+};
+
+} // wing
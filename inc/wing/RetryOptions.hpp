@@ -0,0 +1,31 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace wing {
+
+/**
+ * Automatic retries of queries that failed with a transient error.  A deadlock (1213) or lock
+ * wait timeout (1205) rolled the statement back so it is always retried, a lost connection
+ * (2013) or a server that has gone away (2006) may have applied the statement so only
+ * idempotent queries are retried, see `QueryOptions::idempotent`.  Statements within a
+ * Transaction are never retried.
+ */
+struct RetryOptions {
+    /// The maximum number of times a query is retried.  A value of 0 disables retries.
+    std::size_t max_retries { 0 };
+    /// The delay before the first retry, doubling with each retry up to `backoff_max` and
+    /// jittered between half and the full delay.  Workers are not blocked while a query waits.
+    std::chrono::milliseconds backoff_initial { 10 };
+    /// The longest delay between retries.
+    std::chrono::milliseconds backoff_max { 1000 };
+    /// The retry budget, every started query earns this fraction of a retry and every retry
+    /// spends a whole one.  Once the budget is spent failed queries are not retried, so retries
+    /// can't multiply the load on an overloaded server.
+    double budget_ratio { 0.1 };
+    /// The most retries the budget can save up, the budget starts full.
+    std::size_t budget_burst { 10 };
+};
+
+} // wing
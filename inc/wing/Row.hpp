@@ -8,10 +8,10 @@
 
 namespace wing {
 
-class Query;
+class ResultSet;
 
 class Row {
-    friend Query;
+    friend ResultSet;
 
 public:
     ~Row() = default;
@@ -89,6 +89,67 @@ private:
     /// All parts of the statement, bound or otherwise
     std::vector<StatementPart> m_statement_parts;
 
+    /**
+     * @return The first SQL keyword of the statement upper cased, leading whitespace
+     *         is skipped.  The common table expressions of a `WITH` are skipped, the keyword
+     *         of the statement they belong to is returned.  Empty if the statement has no raw
+     *         parts.
+     */
+    auto leadingKeyword() const -> std::string;
+
+    /**
+     * @return True if this statement is a single row modifying DML statement, e.g.
+     *         INSERT, UPDATE, DELETE or REPLACE, which do not cause an implicit commit.
+     */
+    auto isDml() const -> bool;
+
+    /**
+     * @return True if this statement is a read only SELECT statement.
+     */
+    auto isRead() const -> bool;
+
+    /**
+     * @return True if this statement may modify table data, this is any statement that is not
+     *         a SELECT or a known session or transaction control statement.
+     */
+    auto isWrite() const -> bool;
+
+    /**
+     * @return True if this statement may leave state on the connection's session that a later
+     *         user of the pooled connection could observe, e.g. SET, USE, BEGIN, LOCK TABLES,
+     *         temporary tables, assigned user variables or GET_LOCK().  The check is conservative.
+     */
+    auto changesSession() const -> bool;
+
+    /**
+     * @return True if this statement takes row locks while reading, e.g. SELECT ... FOR UPDATE,
+     *         FOR SHARE or LOCK IN SHARE MODE.
+     */
+    auto isLockingRead() const -> bool;
+
+    /**
+     * Finds the tables this statement reads or writes by scanning for the table references
+     * that follow FROM, JOIN, INTO, UPDATE, TABLE and TRUNCATE.  Database qualifiers are dropped
+     * and names are lower cased.  The scan is conservative, it can report names that are not
+     * tables (e.g. EXTRACT(YEAR FROM column)) but it does not miss tables in plain statements.
+     * @return The distinct table names, sorted.
+     */
+    auto tables() const -> std::vector<std::string>;
+
+    /**
+     * Builds a key that uniquely identifies the final statement this would prepare without
+     * requiring a MySQL connection to escape the bound arguments.  Two statements with equal
+     * keys always prepare the same final statement.
+     * @return The statement's key.
+     */
+    auto key() const -> std::string;
+
+    /**
+     * @return The raw parts of the statement joined together, bound arguments are replaced
+     *         with '?'.
+     */
+    auto rawText() const -> std::string;
+
     /**
      * Prepares a final string statement for use in MySQL by escaping all bound
      * parameters that require escaping using the providing escaping functor
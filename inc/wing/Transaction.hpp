@@ -0,0 +1,238 @@
+#pragma once
+
+#include "wing/Connection.hpp"
+#include "wing/QueryHandle.hpp"
+#include "wing/Statement.hpp"
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace wing {
+
+class Executor;
+class Transaction;
+
+/**
+ * The shared state of a transaction, this keeps the pinned connection between statements
+ * and queues statements that are started while another statement is still executing.
+ */
+class TransactionSession : public std::enable_shared_from_this<TransactionSession> {
+    friend Executor;
+    friend Transaction;
+
+public:
+    ~TransactionSession() = default;
+
+    TransactionSession(const TransactionSession&) = delete;
+    TransactionSession(TransactionSession&&) = delete;
+    auto operator=(const TransactionSession&) noexcept -> TransactionSession& = delete;
+    auto operator=(TransactionSession&&) noexcept -> TransactionSession& = delete;
+
+private:
+    struct Step {
+        wing::Statement m_statement;
+        std::chrono::milliseconds m_timeout;
+        std::function<void(QueryHandle)> m_on_complete;
+    };
+
+    /**
+     * @param executor The executor that runs the transaction's statements.
+     * @param timeout The timeout used for the automatic rollback.
+     * @param queue_index The executor queue all of the transaction's statements are assigned to.
+     */
+    TransactionSession(
+        Executor& executor,
+        std::chrono::milliseconds timeout,
+        std::size_t queue_index);
+
+    /**
+     * Executes the step on the pinned connection, or queues it until the executing step is done.
+     * @param step The statement to execute.
+     * @param finish True if this step ends the transaction, e.g. COMMIT or ROLLBACK.
+     * @return True if the step was accepted, false if the transaction has already finished or
+     *         the executor is stopped.
+     */
+    auto start(
+        Step step,
+        bool finish) -> bool;
+
+    /**
+     * Inspects a step's outcome before its on complete callback is called, the transaction is
+     * broken if the connection was lost or the server rolled the transaction back.
+     * @param query The executed step.
+     * @param connection The pinned connection, nullptr if there is none.
+     */
+    auto inspect(
+        const Query& query,
+        wing::Connection* connection) -> void;
+
+    /**
+     * Collects the cache tags of a completed step, other sessions only see the transaction's
+     * writes once it commits so their cached results are invalidated when it finishes.
+     * @param query The completed step.
+     * @return The tags to invalidate if this step finished a transaction that wrote, an empty
+     *         list if a write could have modified anything.
+     */
+    auto collectCacheTags(
+        const Query& query) -> std::optional<std::vector<std::string>>;
+
+    /**
+     * Called once a step's on complete callback has returned, the next queued step is started on
+     * the connection or, if the transaction is finished, the connection is returned to the pool.
+     * @param connection The pinned connection, nullptr if it was lost.
+     */
+    auto release(
+        std::unique_ptr<wing::Connection> connection) -> void;
+
+    /**
+     * Hands the step to the executor on the pinned connection, the lock must not be held.  If the
+     * transaction is broken the step is completed with an error without being executed.
+     */
+    auto dispatch(
+        std::unique_ptr<wing::Connection> connection,
+        Step step) -> void;
+
+    /**
+     * Marks the transaction as broken, every following step fails without being executed since
+     * the server has already rolled the transaction back.
+     * @param reason The error reported by the following steps.
+     */
+    auto markBroken(
+        std::string reason) -> void;
+
+    /// The executor running this transaction's statements.
+    Executor& m_executor;
+    /// Timeout for the automatic rollback if the transaction is abandoned.
+    std::chrono::milliseconds m_timeout;
+    /// The executor queue the transaction's statements are assigned to.
+    std::size_t m_queue_index;
+
+    std::mutex m_lock;
+    /// The pinned connection while no step is executing.
+    std::unique_ptr<wing::Connection> m_connection { nullptr };
+    /// Is a step queued or executing?  BEGIN is executing when the session is created.
+    bool m_executing { true };
+    /// Steps waiting for the executing step to finish.
+    std::deque<Step> m_pending {};
+    /// Has COMMIT or ROLLBACK been started?
+    bool m_finishing { false };
+    /// The cache tags of the transaction's writes.
+    std::vector<std::string> m_cache_tags {};
+    /// Has a step written to the database?
+    bool m_wrote { false };
+    /// Has a step written without any cache tags, this invalidates the entire cache.
+    bool m_wrote_untagged { false };
+    /// If set the transaction was rolled back by the server or lost its connection.
+    std::optional<std::string> m_broken_reason {};
+};
+
+/**
+ * A transaction runs a sequence of statements asynchronously on a single pinned connection
+ * from the Executor's pool.  BEGIN is sent when the transaction is started, statements can
+ * be started at any time and execute in order, each statement starts once the previous
+ * statement's on complete callback has returned.
+ *
+ * The transaction ends with Commit() or Rollback(), after which the connection is returned to
+ * the pool.  If the Transaction is destroyed before it ends it is rolled back.  Once the
+ * server rolls the transaction back (deadlock) or the connection is lost every following
+ * statement fails without being executed.  Transactions should finish before the Executor is
+ * stopped, statements that have not started by then are dropped.
+ */
+class Transaction {
+    friend Executor;
+
+public:
+    ~Transaction();
+
+    Transaction(const Transaction&) = delete;
+    Transaction(Transaction&&) = default;
+    auto operator=(const Transaction&) -> Transaction& = delete;
+    auto operator=(Transaction&&) -> Transaction& = delete;
+
+    /**
+     * Starts a statement within the transaction.
+     * @param statement The statement to execute.
+     * @param timeout The timeout for this statement.
+     * @param on_complete The on complete callback handler, this is called on the worker that
+     *                    executed the statement.  The next statement does not start until the
+     *                    callback returns.
+     * @return True if the statement has been started or queued for execution.
+     */
+    [[nodiscard]] auto StartQuery(
+        wing::Statement statement,
+        std::chrono::milliseconds timeout,
+        std::function<void(QueryHandle)> on_complete) -> bool;
+
+    /**
+     * Starts a statement within the transaction.
+     * @param statement The statement to execute.
+     * @param timeout The timeout for this statement.
+     * @return If the statement is queued for execution then a future is returned to block on
+     *         until the statement is completed or times out.
+     */
+    [[nodiscard]] auto StartQuery(
+        wing::Statement statement,
+        std::chrono::milliseconds timeout) -> std::optional<std::future<QueryHandle>>;
+
+    /**
+     * Commits the transaction, no further statements can be started.
+     * @param timeout The timeout for the COMMIT.
+     * @param on_complete The on complete callback handler for the COMMIT.
+     * @return True if the COMMIT has been started or queued for execution.
+     */
+    [[nodiscard]] auto Commit(
+        std::chrono::milliseconds timeout,
+        std::function<void(QueryHandle)> on_complete) -> bool;
+
+    /**
+     * Commits the transaction, no further statements can be started.
+     * @param timeout The timeout for the COMMIT.
+     * @return If the COMMIT is queued for execution then a future to its result.
+     */
+    [[nodiscard]] auto Commit(
+        std::chrono::milliseconds timeout) -> std::optional<std::future<QueryHandle>>;
+
+    /**
+     * Rolls the transaction back, no further statements can be started.
+     * @param timeout The timeout for the ROLLBACK.
+     * @param on_complete The on complete callback handler for the ROLLBACK.
+     * @return True if the ROLLBACK has been started or queued for execution.
+     */
+    [[nodiscard]] auto Rollback(
+        std::chrono::milliseconds timeout,
+        std::function<void(QueryHandle)> on_complete) -> bool;
+
+    /**
+     * Rolls the transaction back, no further statements can be started.
+     * @param timeout The timeout for the ROLLBACK.
+     * @return If the ROLLBACK is queued for execution then a future to its result.
+     */
+    [[nodiscard]] auto Rollback(
+        std::chrono::milliseconds timeout) -> std::optional<std::future<QueryHandle>>;
+
+private:
+    explicit Transaction(
+        std::shared_ptr<TransactionSession> session);
+
+    auto start(
+        wing::Statement statement,
+        std::chrono::milliseconds timeout,
+        std::function<void(QueryHandle)> on_complete,
+        bool finish) -> bool;
+
+    auto startFuture(
+        wing::Statement statement,
+        std::chrono::milliseconds timeout,
+        bool finish) -> std::optional<std::future<QueryHandle>>;
+
+    std::shared_ptr<TransactionSession> m_session;
+};
+
+} // wing
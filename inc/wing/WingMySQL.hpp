@@ -1,11 +1,23 @@
 #pragma once
 
+#include "wing/CircuitBreakerOptions.hpp"
+#include "wing/ConcurrencyLimitOptions.hpp"
+#include "wing/Connection.hpp"
 #include "wing/ConnectionInfo.hpp"
+#include "wing/ConnectionOptions.hpp"
 #include "wing/Executor.hpp"
+#include "wing/ExecutorOptions.hpp"
+#include "wing/HedgeOptions.hpp"
 #include "wing/Query.hpp"
 #include "wing/QueryHandle.hpp"
+#include "wing/QueryOptions.hpp"
 #include "wing/QueryPool.hpp"
+#include "wing/QueryPoolOptions.hpp"
 #include "wing/QueryStatus.hpp"
+#include "wing/ResultCache.hpp"
+#include "wing/ResultSet.hpp"
+#include "wing/RetryOptions.hpp"
+#include "wing/Transaction.hpp"
 
 namespace wing {
 class GlobalScopeInitializer {
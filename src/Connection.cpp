@@ -0,0 +1,321 @@
+#include "wing/Connection.hpp"
+#include "wing/QueryPool.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <mysql/errmsg.h>
+#include <mysql/mysqld_error.h>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+namespace wing {
+
+Connection::~Connection()
+{
+    mysql_close(&m_mysql);
+    if (m_pooled) {
+        m_query_pool.connectionDestroyed();
+    }
+}
+
+Connection::Connection(
+    QueryPool& query_pool,
+    const ConnectionInfo& connection_info)
+    : m_query_pool(query_pool)
+    , m_connection_info(connection_info)
+{
+    mysql_init(&m_mysql);
+
+    const auto& options = m_connection_info.Options();
+
+    auto to_seconds = [](std::chrono::milliseconds timeout) {
+        return static_cast<unsigned int>(std::chrono::duration_cast<std::chrono::seconds>(timeout).count());
+    };
+
+    unsigned int connect_timeout = std::max(to_seconds(options.connect_timeout), 1u);
+    mysql_options(&m_mysql, MYSQL_OPT_CONNECT_TIMEOUT, &connect_timeout);
+
+    if (options.write_timeout > std::chrono::milliseconds { 0 }) {
+        unsigned int write_timeout = to_seconds(options.write_timeout);
+        mysql_options(&m_mysql, MYSQL_OPT_WRITE_TIMEOUT, &write_timeout);
+    }
+
+    if (options.max_allowed_packet > 0) {
+        unsigned long max_allowed_packet = options.max_allowed_packet;
+        mysql_options(&m_mysql, MYSQL_OPT_MAX_ALLOWED_PACKET, &max_allowed_packet);
+    }
+
+    if (!options.charset.empty()) {
+        mysql_options(&m_mysql, MYSQL_SET_CHARSET_NAME, options.charset.c_str());
+    }
+
+    switch (options.compression) {
+        case CompressionAlgorithm::NONE:
+            break;
+        case CompressionAlgorithm::ZLIB:
+            mysql_options(&m_mysql, MYSQL_OPT_COMPRESS, nullptr);
+            break;
+        case CompressionAlgorithm::ZSTD: {
+#ifdef WING_MYSQL_OPT_COMPRESSION_ALGORITHMS_DISABLED
+            // Older clients only support zlib.
+            mysql_options(&m_mysql, MYSQL_OPT_COMPRESS, nullptr);
+#else
+            mysql_options(&m_mysql, MYSQL_OPT_COMPRESSION_ALGORITHMS, "zstd");
+            unsigned int compression_level = options.compression_level;
+            mysql_options(&m_mysql, MYSQL_OPT_ZSTD_COMPRESSION_LEVEL, &compression_level);
+#endif
+        } break;
+    }
+
+    setReconnect(options.auto_reconnect);
+
+    // The init command is also executed when the client automatically reconnects.
+    if (!m_query_pool.m_session_init.empty()) {
+        mysql_options(&m_mysql, MYSQL_INIT_COMMAND, m_query_pool.m_session_init.c_str());
+    }
+
+#ifdef WING_MYSQL_OPT_SSL_ENFORCE_DISABLED
+    bool ssl = false;
+    mysql_options(&m_mysql, MYSQL_OPT_SSL_ENFORCE, &ssl);
+#endif
+
+    //  Some mysql libraries do not support SSL_MODE_DISABLED
+#ifdef WING_PERCONA_SSL_DISABLED
+    uint32_t ssl_mode = SSL_MODE_DISABLED;
+    mysql_options(&m_mysql, MYSQL_OPT_SSL_MODE, &ssl_mode);
+#endif
+}
+
+auto Connection::connect() -> bool
+{
+    if (!m_is_connected) {
+        if (m_connect_failed) {
+            return false;
+        }
+
+        // The pool limits concurrent connects and backs off after failures so a restarted server
+        // isn't flooded with handshakes.
+        m_connect_throttled = !m_query_pool.beginConnect();
+        if (m_connect_throttled) {
+            return false;
+        }
+
+        auto* success = mysql_real_connect(
+            &m_mysql,
+            m_connection_info.Host().c_str(),
+            m_connection_info.User().c_str(),
+            m_connection_info.Password().c_str(),
+            m_connection_info.Database().c_str(),
+            m_connection_info.Port(),
+            m_connection_info.Socket().c_str(),
+            m_connection_info.ClientFlags());
+
+        m_query_pool.endConnect(success != nullptr);
+        if (success == nullptr) {
+            m_connect_failed = true;
+            return false;
+        }
+
+        m_is_connected = true;
+        m_connected_at = std::chrono::steady_clock::now();
+        setSocketOptions();
+    }
+
+    return true;
+}
+
+auto Connection::setReadTimeout(
+    std::chrono::milliseconds timeout) -> void
+{
+    auto timeout_seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    unsigned int read_timeout = static_cast<unsigned int>(timeout_seconds.count());
+    mysql_options(&m_mysql, MYSQL_OPT_READ_TIMEOUT, &read_timeout);
+}
+
+auto Connection::setConnectTimeout(
+    std::chrono::milliseconds timeout) -> void
+{
+    auto timeout_seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    unsigned int connect_timeout = std::max(static_cast<unsigned int>(timeout_seconds.count()), 1u);
+    mysql_options(&m_mysql, MYSQL_OPT_CONNECT_TIMEOUT, &connect_timeout);
+}
+
+auto Connection::executeControl(
+    std::string_view statement) -> bool
+{
+    bool succeeded = (0 == mysql_real_query(&m_mysql, statement.data(), statement.length()));
+    refreshSocketOptions();
+    return succeeded;
+}
+
+auto Connection::isBroken() -> bool
+{
+    auto error_number = mysql_errno(&m_mysql);
+    return (error_number >= CR_MIN_ERROR && error_number <= CR_MAX_ERROR)
+        || error_number == ER_SERVER_SHUTDOWN;
+}
+
+auto Connection::ping() -> bool
+{
+    setReconnect(false);
+    bool alive = (mysql_ping(&m_mysql) == 0);
+    setReconnect(m_connection_info.Options().auto_reconnect);
+
+    if (alive) {
+        m_pinged_at = std::chrono::steady_clock::now();
+    }
+    return alive;
+}
+
+auto Connection::resetSession(
+    ConnectionResetPolicy policy) -> bool
+{
+    bool reset = (policy == ConnectionResetPolicy::ALWAYS)
+        || (policy == ConnectionResetPolicy::ON_SESSION_CHANGE && m_session_changed);
+
+    if (reset && m_is_connected) {
+        if (mysql_reset_connection(&m_mysql) != 0) {
+            return false;
+        }
+
+        if (!m_query_pool.m_session_init.empty() && !executeControl(m_query_pool.m_session_init)) {
+            return false;
+        }
+    }
+
+    m_session_changed = false;
+    return true;
+}
+
+auto Connection::trackedGtids() -> std::string
+{
+    const char* data = nullptr;
+    std::size_t length = 0;
+    if (mysql_session_track_get_first(&m_mysql, SESSION_TRACK_GTIDS, &data, &length) != 0 || data == nullptr) {
+        return {};
+    }
+
+    return std::string { data, length };
+}
+
+auto Connection::waitForGtids(
+    const std::string& gtid_set,
+    std::chrono::milliseconds timeout) -> bool
+{
+    if (!connect()) {
+        return false;
+    }
+
+    std::string escaped {};
+    escaped.resize(gtid_set.length() * 2 + 1);
+    escaped.resize(mysql_real_escape_string(&m_mysql, escaped.data(), gtid_set.data(), gtid_set.length()));
+
+    std::chrono::duration<double> timeout_seconds = timeout;
+    std::string sql = "SELECT WAIT_FOR_EXECUTED_GTID_SET('" + escaped + "', " + std::to_string(timeout_seconds.count()) + ")";
+    if (mysql_real_query(&m_mysql, sql.data(), sql.length()) != 0) {
+        return false;
+    }
+
+    auto* result = mysql_store_result(&m_mysql);
+    if (result == nullptr) {
+        return false;
+    }
+
+    // 0 once the set is applied, 1 on timeout.
+    auto* row = mysql_fetch_row(result);
+    bool applied = (row != nullptr && row[0] != nullptr && std::string_view { row[0] } == "0");
+    mysql_free_result(result);
+    return applied;
+}
+
+auto Connection::replicationLag(
+    const std::string& statement) -> std::optional<std::chrono::milliseconds>
+{
+    auto query_lag = [this](std::string_view sql, bool by_name) -> std::optional<std::chrono::milliseconds> {
+        if (mysql_real_query(&m_mysql, sql.data(), sql.length()) != 0) {
+            return std::nullopt;
+        }
+
+        auto* result = mysql_store_result(&m_mysql);
+        if (result == nullptr) {
+            return std::nullopt;
+        }
+
+        std::optional<std::chrono::milliseconds> lag {};
+        auto field_count = mysql_num_fields(result);
+        auto* row = mysql_fetch_row(result);
+        if (row != nullptr && field_count > 0) {
+            std::size_t column = 0;
+            if (by_name) {
+                column = field_count;
+                auto* fields = mysql_fetch_fields(result);
+                for (std::size_t i = 0; i < field_count; ++i) {
+                    std::string_view name { fields[i].name };
+                    if (name == "Seconds_Behind_Source" || name == "Seconds_Behind_Master") {
+                        column = i;
+                        break;
+                    }
+                }
+            }
+
+            // A NULL lag means replication isn't running.
+            if (column < field_count && row[column] != nullptr) {
+                std::chrono::duration<double> seconds { std::strtod(row[column], nullptr) };
+                lag = std::chrono::duration_cast<std::chrono::milliseconds>(seconds);
+            }
+        }
+
+        mysql_free_result(result);
+        return lag;
+    };
+
+    if (!statement.empty()) {
+        return query_lag(statement, false);
+    }
+
+    auto lag = query_lag("SHOW REPLICA STATUS", true);
+    if (!lag.has_value() && mysql_errno(&m_mysql) == ER_PARSE_ERROR) {
+        lag = query_lag("SHOW SLAVE STATUS", true);
+    }
+    return lag;
+}
+
+auto Connection::setSocketOptions() -> void
+{
+    // The client library has no options for these, they are set directly on the connected socket,
+    // unix sockets ignore them.
+    const auto& options = m_connection_info.Options();
+    auto fd = m_mysql.net.fd;
+
+    int keepalive = options.tcp_keepalive ? 1 : 0;
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &keepalive, sizeof(keepalive));
+
+    if (options.tcp_keepalive && options.tcp_keepalive_idle > std::chrono::milliseconds { 0 }) {
+        int idle = static_cast<int>(std::chrono::duration_cast<std::chrono::seconds>(options.tcp_keepalive_idle).count());
+        setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+    }
+
+    int nodelay = options.tcp_nodelay ? 1 : 0;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    m_socket_thread_id = mysql_thread_id(&m_mysql);
+}
+
+auto Connection::refreshSocketOptions() -> void
+{
+    if (m_is_connected && mysql_thread_id(&m_mysql) != m_socket_thread_id) {
+        setSocketOptions();
+    }
+}
+
+auto Connection::setReconnect(
+    bool reconnect) -> void
+{
+    uint64_t auto_reconnect = reconnect ? 1 : 0;
+    mysql_options(&m_mysql, MYSQL_OPT_RECONNECT, &auto_reconnect);
+}
+
+} // wing
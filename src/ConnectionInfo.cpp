@@ -8,7 +8,8 @@ ConnectionInfo::ConnectionInfo(
     std::string user,
     std::string password,
     std::string database,
-    uint64_t client_flags)
+    uint64_t client_flags,
+    ConnectionOptions options)
     : m_host(std::move(host))
     , m_port(port)
     , m_socket("0")
@@ -16,6 +17,7 @@ ConnectionInfo::ConnectionInfo(
     , m_password(std::move(password))
     , m_database(std::move(database))
     , m_client_flags(client_flags)
+    , m_options(std::move(options))
 {
 }
 
@@ -24,7 +26,8 @@ ConnectionInfo::ConnectionInfo(
     std::string user,
     std::string password,
     std::string database,
-    uint64_t client_flags)
+    uint64_t client_flags,
+    ConnectionOptions options)
     : m_host("localhost")
     , m_port(0)
     , m_socket(std::move(socket))
@@ -32,6 +35,7 @@ ConnectionInfo::ConnectionInfo(
     , m_password(std::move(password))
     , m_database(std::move(database))
     , m_client_flags(client_flags)
+    , m_options(std::move(options))
 {
 }
 
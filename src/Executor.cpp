@@ -1,5 +1,14 @@
 #include "wing/Executor.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <random>
+#include <utility>
+
+#include <mysql/errmsg.h>
+#include <mysql/mysqld_error.h>
+
 #include <sys/syscall.h>
 #include <unistd.h>
 
@@ -13,11 +22,127 @@ Worker::Worker(
 {
 }
 
+Worker::Worker(
+    Worker&& other)
+    : m_thread(std::move(other.m_thread))
+    , m_worker_idx(other.m_worker_idx)
+    , m_native_handle(std::move(other.m_native_handle))
+    , m_tid(std::move(other.m_tid))
+    , m_connections(std::move(other.m_connections))
+    , m_completed_query_count(other.m_completed_query_count.load())
+    , m_cached_connection_count(other.m_cached_connection_count.load())
+{
+}
+
+auto QueryQueue::push(
+    QueryHandle query_handle,
+    double weight,
+    bool front) -> void
+{
+    ++m_size;
+    if (front) {
+        m_urgent.emplace_back(std::move(query_handle));
+        return;
+    }
+
+    auto [iter, inserted] = m_tenants.try_emplace(query_handle->m_options.tenant);
+    auto& tenant_queue = iter->second;
+    tenant_queue.m_weight = weight;
+    if (inserted) {
+        tenant_queue.m_tenant = &iter->first;
+        tenant_queue.m_scheduled_at = { m_virtual_time, m_schedule_sequence++ };
+        m_schedule.emplace(tenant_queue.m_scheduled_at, &tenant_queue);
+    }
+    tenant_queue.m_queries.emplace_back(std::move(query_handle));
+}
+
+auto QueryQueue::pop() -> QueryHandle
+{
+    if (!m_urgent.empty()) {
+        --m_size;
+        auto query_handle = std::move(m_urgent.front());
+        m_urgent.pop_front();
+        return query_handle;
+    }
+
+    auto& tenant_queue = *m_schedule.begin()->second;
+    m_virtual_time = tenant_queue.m_scheduled_at.first;
+    return take(tenant_queue);
+}
+
+auto QueryQueue::popGroupCommit(
+    const std::string& tenant) -> std::optional<QueryHandle>
+{
+    // A write resumed by the concurrency limit holds a slot of its own, it executes by itself.
+    auto found = m_tenants.find(tenant);
+    if (found == m_tenants.end()
+        || !found->second.m_queries.front()->isGroupCommitEligible()
+        || found->second.m_queries.front()->m_limit_pool != nullptr) {
+        return std::nullopt;
+    }
+
+    return take(found->second);
+}
+
+auto QueryQueue::take(
+    TenantQueue& tenant_queue) -> QueryHandle
+{
+    --m_size;
+    auto query_handle = std::move(tenant_queue.m_queries.front());
+    tenant_queue.m_queries.pop_front();
+
+    m_schedule.erase(tenant_queue.m_scheduled_at);
+    if (tenant_queue.m_queries.empty()) {
+        // The tenant starts over at the current virtual time when it queues again.
+        m_tenants.erase(*tenant_queue.m_tenant);
+    } else {
+        tenant_queue.m_scheduled_at = { tenant_queue.m_scheduled_at.first + 1.0 / tenant_queue.m_weight, m_schedule_sequence++ };
+        m_schedule.emplace(tenant_queue.m_scheduled_at, &tenant_queue);
+    }
+
+    return query_handle;
+}
+
 Executor::Executor(
     ConnectionInfo connection_info,
-    std::size_t num_workers)
-    : m_query_pool(std::move(connection_info))
+    std::size_t num_workers,
+    ExecutorOptions options)
+    : Executor(std::move(connection_info), std::vector<ConnectionInfo> {}, num_workers, std::move(options))
 {
+}
+
+Executor::Executor(
+    ConnectionInfo primary,
+    std::vector<ConnectionInfo> replicas,
+    std::size_t num_workers,
+    ExecutorOptions options)
+    : m_options(std::move(options))
+    , m_query_pool(
+          std::move(primary),
+          m_options.query_pool,
+          m_options.track_gtids ? "SET SESSION session_track_gtids = OWN_GTID" : "")
+{
+    m_replica_pools.reserve(replicas.size());
+    for (auto& replica : replicas) {
+        // Calling new instead of std::make_unique since the ctor is private
+        m_replica_pools.emplace_back(std::unique_ptr<QueryPool>(new QueryPool(std::move(replica), m_options.query_pool)));
+    }
+
+    if (m_options.standby.has_value()) {
+        auto standby_options = m_options.query_pool;
+        standby_options.min_idle = std::max(standby_options.min_idle, m_options.standby_min_idle);
+        // Calling new instead of std::make_unique since the ctor is private
+        m_standby_pool = std::unique_ptr<QueryPool>(new QueryPool(
+            m_options.standby.value(),
+            standby_options,
+            m_options.track_gtids ? "SET SESSION session_track_gtids = OWN_GTID" : ""));
+    }
+
+    if (m_options.result_cache_max_bytes > 0) {
+        // Calling new instead of std::make_unique since the ctor is private
+        m_result_cache = std::unique_ptr<ResultCache>(new ResultCache(m_options.result_cache_max_bytes));
+    }
+
     if (num_workers == 0) {
         num_workers = 1;
     }
@@ -26,6 +151,13 @@ Executor::Executor(
         num_workers = 1024;
     }
 
+    auto num_queues = m_options.shared_nothing ? num_workers : 1;
+    m_queues.reserve(num_queues);
+    for (std::size_t i = 0; i < num_queues; ++i) {
+        // Calling new instead of std::make_unique since the ctor is private
+        m_queues.emplace_back(std::unique_ptr<QueryQueue>(new QueryQueue()));
+    }
+
     m_workers.reserve(num_workers);
 
     for (std::size_t i = 0; i < num_workers; ++i) {
@@ -37,6 +169,25 @@ Executor::Executor(
     }
 
     m_start = true;
+
+    bool sample_lag = !m_replica_pools.empty() && m_options.replica_lag_interval > std::chrono::milliseconds { 0 };
+    bool probe_health = (!m_replica_pools.empty() || m_standby_pool != nullptr)
+        && m_options.health_check_interval > std::chrono::milliseconds { 0 };
+    bool shed_parked = m_options.concurrency_limit.initial_limit > 0
+        && m_options.concurrency_limit.max_wait > std::chrono::milliseconds { 0 };
+    if (sample_lag || probe_health || shed_parked) {
+        m_monitor_thread.emplace([this]() { monitor(); });
+    }
+
+    if (m_options.retry.max_retries > 0) {
+        m_retry_budget = static_cast<double>(m_options.retry.budget_burst);
+        m_retry_thread.emplace([this]() { retrier(); });
+    }
+
+    if (m_options.hedge.percentile > 0.0 && m_replica_pools.size() >= 2) {
+        m_hedge_samples.reserve(std::max<std::size_t>(m_options.hedge.window, 1));
+        m_hedge_thread.emplace([this]() { hedger(); });
+    }
 }
 
 Executor::~Executor()
@@ -47,12 +198,60 @@ Executor::~Executor()
     for (auto& worker : m_workers) {
         worker.m_thread.join();
     }
+
+    if (m_monitor_thread.has_value()) {
+        m_monitor_thread.value().join();
+    }
+
+    if (m_retry_thread.has_value()) {
+        m_retry_thread.value().join();
+    }
+
+    if (m_hedge_thread.has_value()) {
+        m_hedge_thread.value().join();
+    }
+
+    // Nothing resumes the queries still parked by the concurrency limit, nor executes queries
+    // queued again after their worker exited.  They are completed so their callers don't wait
+    // forever.
+    auto drain = [this](QueryPool& query_pool) {
+        for (auto& query_handle : query_pool.limitDrain()) {
+            complete(std::move(query_handle));
+        }
+    };
+    drain(m_query_pool);
+    for (auto& replica_pool : m_replica_pools) {
+        drain(*replica_pool);
+    }
+    if (m_standby_pool != nullptr) {
+        drain(*m_standby_pool);
+    }
+
+    for (auto& queue : m_queues) {
+        while (!queue->empty()) {
+            auto query_handle = queue->pop();
+            if (query_handle->m_query_status == QueryStatus::BUILDING) {
+                query_handle->setError(QueryStatus::ERROR, "Executor stopped before the query executed");
+            }
+            complete(std::move(query_handle));
+        }
+    }
+}
+
+auto Executor::ActiveQueryCount() const -> uint64_t
+{
+    uint64_t count = 0;
+    for (const auto& queue : m_queues) {
+        count += queue->m_active_query_count;
+    }
+    return count;
 }
 
 auto Executor::StartQuery(
     wing::Statement statement,
     std::chrono::milliseconds timeout,
-    std::function<void(QueryHandle)> on_complete) -> bool
+    std::function<void(QueryHandle)> on_complete,
+    QueryOptions options) -> bool
 {
     if (m_stop) {
         return false;
@@ -62,22 +261,61 @@ auto Executor::StartQuery(
         std::move(statement),
         timeout,
         std::move(on_complete));
+    query_handle->m_options = std::move(options);
+    query_handle->m_target_pool = &route(*query_handle);
 
-    {
-        std::lock_guard<std::mutex> g { m_query_queue_mutex };
-        m_query_queue.emplace_back(std::move(query_handle));
+    if (m_options.retry.max_retries > 0) {
+        std::lock_guard<std::mutex> guard { m_retry_mutex };
+        m_retry_budget = std::min(m_retry_budget + m_options.retry.budget_ratio, static_cast<double>(m_options.retry.budget_burst));
     }
+    query_handle->m_queue_index = queueFor(query_handle->m_options);
+    auto& active_query_count = m_queues[query_handle->m_queue_index]->m_active_query_count;
 
-    ++m_active_query_count;
+    bool cacheable = (m_result_cache != nullptr && query_handle->isCacheable());
+    bool single_flight = query_handle->isSingleFlightEligible();
 
-    m_wait_cv.notify_one();
+    if (cacheable || single_flight) {
+        query_handle->m_statement_key = query_handle->statementKey();
+    }
+    if (cacheable) {
+        query_handle->m_cache_epoch = m_result_cache->beginRead();
+        query_handle->m_cache_reading = true;
+    }
+
+    // A cache hit is still handed to a worker to complete, it just skips execution.
+    if (!cacheable || !m_result_cache->find(query_handle->m_statement_key, *query_handle)) {
+        if (query_handle->m_target_pool->circuitOpen(m_options.circuit_breaker)) {
+            // Completed on a worker without executing, the server is failing.
+            query_handle->setError(QueryStatus::CIRCUIT_OPEN, "Circuit breaker is open, the server is failing");
+        } else if (single_flight) {
+            std::lock_guard<std::mutex> g { m_single_flight_mutex };
+            auto found = m_single_flights.find(query_handle->m_statement_key);
+            if (found != m_single_flights.end()) {
+                // An identical read is already in flight, wait for its result instead of executing.
+                found->second.emplace_back(std::move(query_handle));
+                ++active_query_count;
+                return true;
+            }
+
+            m_single_flights.emplace(query_handle->m_statement_key, std::vector<QueryHandle> {});
+            query_handle->m_leads_single_flight = true;
+        }
+    }
+
+    if (query_handle->m_query_status == QueryStatus::BUILDING && !query_handle->m_leads_single_flight) {
+        hedge(query_handle);
+    }
+
+    ++active_query_count;
+    enqueue(std::move(query_handle));
 
     return true;
 }
 
 auto Executor::StartQuery(
     wing::Statement statement,
-    std::chrono::milliseconds timeout) -> std::optional<std::future<QueryHandle>>
+    std::chrono::milliseconds timeout,
+    QueryOptions options) -> std::optional<std::future<QueryHandle>>
 {
     std::optional<std::future<QueryHandle>> result {};
 
@@ -90,13 +328,264 @@ auto Executor::StartQuery(
             timeout,
             [p = std::move(query_promise_ptr)](QueryHandle query_handle) mutable {
                 p->set_value(std::move(query_handle));
-            })) {
+            },
+            std::move(options))) {
         result.emplace(std::move(query_future));
     }
 
     return result;
 }
 
+auto Executor::StartTransaction(
+    std::chrono::milliseconds timeout) -> std::optional<Transaction>
+{
+    if (m_stop) {
+        return std::nullopt;
+    }
+
+    // Calling new instead of std::make_shared since the ctor is private
+    auto session = std::shared_ptr<TransactionSession>(new TransactionSession(*this, timeout, queueFor(QueryOptions {})));
+
+    wing::Statement begin_stm {};
+    begin_stm << "BEGIN";
+    auto query_handle = m_query_pool.Produce(
+        std::move(begin_stm),
+        timeout,
+        [](QueryHandle begin_handle) {
+            if (begin_handle->QueryStatus() != QueryStatus::SUCCESS) {
+                begin_handle->m_session->markBroken("Transaction failed to begin: " + begin_handle->ErrorOr("unknown error"));
+            }
+        });
+    query_handle->m_session = session;
+    query_handle->m_target_pool = &primary();
+    query_handle->m_queue_index = session->m_queue_index;
+    if (query_handle->m_target_pool->circuitOpen(m_options.circuit_breaker)) {
+        // The BEGIN's callback marks the transaction broken.
+        query_handle->setError(QueryStatus::CIRCUIT_OPEN, "Circuit breaker is open, the server is failing");
+    }
+
+    ++m_queues[session->m_queue_index]->m_active_query_count;
+    enqueue(std::move(query_handle));
+
+    return Transaction { std::move(session) };
+}
+
+auto Executor::tenantWeight(
+    const std::string& tenant) const -> double
+{
+    auto found = m_options.tenant_weights.find(tenant);
+    if (found == m_options.tenant_weights.end() || found->second <= 0.0) {
+        return 1.0;
+    }
+    return found->second;
+}
+
+auto Executor::queueFor(
+    const QueryOptions& options) -> std::size_t
+{
+    if (m_queues.size() == 1) {
+        return 0;
+    }
+
+    if (!options.shard_key.empty()) {
+        return std::hash<std::string> {}(options.shard_key) % m_queues.size();
+    }
+
+    return m_next_queue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+}
+
+template<typename PoolAt>
+auto Executor::balance(
+    std::size_t count,
+    PoolAt pool_at) -> QueryPool&
+{
+    if (m_options.replica_balancing == ReplicaBalancing::ROUND_ROBIN || count == 1) {
+        return pool_at(m_next_replica.fetch_add(1, std::memory_order_relaxed) % count);
+    }
+
+    // Power of two choices, comparing two random replicas avoids herding every read onto the
+    // single replica that looked best a moment ago.
+    static thread_local std::minstd_rand g_random { std::random_device {}() };
+    std::uniform_int_distribution<std::size_t> pick { 0, count - 1 };
+    auto first = pick(g_random);
+    auto second = pick(g_random);
+    if (second == first) {
+        second = (first + 1) % count;
+    }
+
+    QueryPool& first_pool = pool_at(first);
+    QueryPool& second_pool = pool_at(second);
+    auto decay = m_options.replica_latency_decay;
+    return (second_pool.loadCost(decay) < first_pool.loadCost(decay)) ? second_pool : first_pool;
+}
+
+auto Executor::route(
+    const Query& query) -> QueryPool&
+{
+    if (m_replica_pools.empty() || !query.isReplicaEligible()) {
+        return primary();
+    }
+
+    // The primary is never stale, it only takes the reads no replica can serve.
+    auto candidates = replicaCandidates(query);
+    if (candidates.empty()) {
+        return primary();
+    }
+
+    return balance(candidates.size(), [&candidates](std::size_t i) -> QueryPool& { return *candidates[i]; });
+}
+
+auto Executor::replicaCandidates(
+    const Query& query) -> std::vector<QueryPool*>
+{
+    auto max_staleness = query.m_options.max_staleness;
+    auto now = std::chrono::steady_clock::now();
+
+    std::vector<QueryPool*> candidates {};
+    candidates.reserve(m_replica_pools.size());
+    for (auto& replica_pool : m_replica_pools) {
+        if (!replica_pool->Healthy() || replica_pool->circuitOpen(m_options.circuit_breaker)) {
+            continue;
+        }
+
+        if (max_staleness > std::chrono::milliseconds { 0 }) {
+            auto staleness = replica_pool->staleness(now);
+            if (!staleness.has_value() || staleness.value() > max_staleness) {
+                continue;
+            }
+        }
+
+        candidates.emplace_back(replica_pool.get());
+    }
+
+    return candidates;
+}
+
+auto Executor::primary() -> QueryPool&
+{
+    if (m_standby_pool != nullptr && !m_query_pool.Healthy() && m_standby_pool->Healthy()) {
+        return *m_standby_pool;
+    }
+
+    return m_query_pool;
+}
+
+auto Executor::monitor() -> void
+{
+    mysql_thread_init();
+
+    auto lag_interval = m_replica_pools.empty() ? std::chrono::milliseconds { 0 } : m_options.replica_lag_interval;
+    auto health_interval = (m_replica_pools.empty() && m_standby_pool == nullptr) ? std::chrono::milliseconds { 0 } : m_options.health_check_interval;
+
+    bool shed_parked = m_options.concurrency_limit.initial_limit > 0
+        && m_options.concurrency_limit.max_wait > std::chrono::milliseconds { 0 };
+
+    auto next_lag_sample = std::chrono::steady_clock::now();
+    auto next_health_probe = next_lag_sample;
+
+    while (!m_stop) {
+        auto now = std::chrono::steady_clock::now();
+        auto next_wake = std::chrono::steady_clock::time_point::max();
+
+        if (shed_parked) {
+            // Parked queries are also shed whenever a slot frees up, this bounds their wait when
+            // the admitted queries are slow.
+            auto expire = [this, &next_wake](QueryPool& query_pool) {
+                resume(query_pool.limitExpire(m_options.concurrency_limit, next_wake));
+            };
+            expire(m_query_pool);
+            for (auto& replica_pool : m_replica_pools) {
+                expire(*replica_pool);
+            }
+            if (m_standby_pool != nullptr) {
+                expire(*m_standby_pool);
+            }
+        }
+
+        if (lag_interval > std::chrono::milliseconds { 0 }) {
+            if (now >= next_lag_sample) {
+                sampleReplicationLag();
+                next_lag_sample = now + lag_interval;
+            }
+            next_wake = std::min(next_wake, next_lag_sample);
+        }
+
+        if (health_interval > std::chrono::milliseconds { 0 }) {
+            if (now >= next_health_probe) {
+                probeHealth();
+                next_health_probe = now + health_interval;
+            }
+            next_wake = std::min(next_wake, next_health_probe);
+        }
+
+        std::unique_lock<std::mutex> lock { m_monitor_mutex };
+        m_monitor_cv.wait_until(lock, next_wake, [this]() { return m_stop || m_monitor_parked; });
+        m_monitor_parked = false;
+    }
+
+    mysql_thread_end();
+}
+
+auto Executor::sampleReplicationLag() -> void
+{
+    // The read timeout has a whole second granularity, a sample slower than the interval
+    // rounded up to a second is abandoned and the replica is treated as lagging.
+    auto read_timeout = std::chrono::ceil<std::chrono::seconds>(std::max<std::chrono::milliseconds>(m_options.replica_lag_interval, std::chrono::seconds { 1 }));
+
+    m_lag_connections.resize(m_replica_pools.size());
+    for (std::size_t i = 0; i < m_replica_pools.size(); ++i) {
+        auto& replica_pool = *m_replica_pools[i];
+        auto& connection = m_lag_connections[i];
+        if (connection == nullptr) {
+            connection = replica_pool.controlConnection();
+            connection->setReadTimeout(read_timeout);
+            connection->setReconnect(false);
+        }
+
+        std::optional<std::chrono::milliseconds> lag {};
+        if (connection->connect()) {
+            lag = connection->replicationLag(m_options.replica_lag_statement);
+        }
+        if (!connection->m_is_connected || connection->isBroken()) {
+            // Reconnected on the next sample.
+            connection = nullptr;
+        }
+        replica_pool.replicationLag(lag);
+    }
+}
+
+auto Executor::probeHealth() -> void
+{
+    auto probe = [this](QueryPool& query_pool) {
+        auto alive = query_pool.probe();
+        if (alive.has_value()) {
+            query_pool.recordHealth(alive.value(), m_options.unhealthy_threshold);
+        }
+    };
+
+    probe(m_query_pool);
+    for (auto& replica_pool : m_replica_pools) {
+        probe(*replica_pool);
+    }
+    if (m_standby_pool != nullptr) {
+        probe(*m_standby_pool);
+    }
+}
+
+auto Executor::enqueue(
+    QueryHandle query_handle,
+    bool front) -> void
+{
+    auto& queue = *m_queues[query_handle->m_queue_index];
+    {
+        auto weight = tenantWeight(query_handle->m_options.tenant);
+        std::lock_guard<std::mutex> g { queue.m_mutex };
+        queue.push(std::move(query_handle), weight, front);
+    }
+
+    queue.m_wait_cv.notify_one();
+}
+
 auto Executor::executor(
     std::size_t worker_index) -> void
 {
@@ -117,38 +606,928 @@ auto Executor::executor(
 
     mysql_thread_init();
 
+    auto& worker = m_workers[worker_index];
+    auto& queue = *m_queues[m_options.shared_nothing ? worker_index : 0];
+    auto keepalive_interval = m_options.query_pool.keepalive_interval;
+    auto reclaim_interval = reclaimTimeout();
+
+    // Idle workers wake up to maintain the connections they cache, shared nothing workers keep
+    // their connections alive while other workers hand idle connections back to the pool.
+    auto maintenance_interval = std::chrono::milliseconds { 0 };
+    if (keepalive_interval > std::chrono::milliseconds { 0 }) {
+        maintenance_interval = keepalive_interval;
+    }
+    if (!m_options.shared_nothing && m_options.worker_connection_cache_size > 0
+        && (maintenance_interval == std::chrono::milliseconds { 0 } || reclaim_interval < maintenance_interval)) {
+        maintenance_interval = reclaim_interval;
+    }
+
     while (!m_stop) {
         // Wait until there are queries ready to execute or this execution context is being stopped.
         {
-            std::unique_lock<std::mutex> wait_lock { m_query_queue_mutex };
-            m_wait_cv.wait(
-                wait_lock,
-                [this]() { return !m_query_queue.empty() || m_stop; });
+            std::unique_lock<std::mutex> wait_lock { queue.m_mutex };
+            auto ready = [this, &queue]() { return !queue.empty() || m_stop; };
+            if (maintenance_interval > std::chrono::milliseconds { 0 }) {
+                if (!queue.m_wait_cv.wait_for(wait_lock, maintenance_interval, ready)) {
+                    wait_lock.unlock();
+                    if (!m_options.shared_nothing) {
+                        reclaim(worker);
+                    }
+                    keepalive(worker);
+                    continue;
+                }
+            } else {
+                queue.m_wait_cv.wait(wait_lock, ready);
+            }
         }
 
         while (true) {
             QueryHandle query_handle { nullptr };
+            std::vector<QueryHandle> group_commit_batch {};
             {
-                std::lock_guard<std::mutex> g { m_query_queue_mutex };
-                if (!m_query_queue.empty()) {
-                    query_handle = std::move(m_query_queue.front());
-                    m_query_queue.pop_front();
+                std::lock_guard<std::mutex> g { queue.m_mutex };
+                if (!queue.empty()) {
+                    query_handle = queue.pop();
+
+                    // Coalesce any group commit writes of the same tenant directly behind this
+                    // one, stopping at the first query that isn't eligible to keep the tenant's
+                    // ordering intact.
+                    if (m_options.group_commit_max_batch_size > 1 && query_handle->isGroupCommitEligible()) {
+                        while (group_commit_batch.size() + 1 < m_options.group_commit_max_batch_size) {
+                            auto next = queue.popGroupCommit(query_handle->m_options.tenant);
+                            if (!next.has_value()) {
+                                break;
+                            }
+                            group_commit_batch.emplace_back(std::move(next.value()));
+                        }
+                    }
                 }
             }
 
             if (query_handle.query_ptr != nullptr) {
-                query_handle->execute();
-                auto on_complete = std::move(query_handle->m_on_complete);
-                on_complete(std::move(query_handle));
-                --m_active_query_count;
+                if (group_commit_batch.empty()) {
+                    execute(worker, std::move(query_handle));
+                    worker.m_completed_query_count.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    group_commit_batch.insert(group_commit_batch.begin(), std::move(query_handle));
+                    executeGroupCommit(worker, group_commit_batch);
+                    for (auto& batched_query_handle : group_commit_batch) {
+                        // Parked writes are completed once they are resumed.
+                        if (batched_query_handle.query_ptr != nullptr) {
+                            if (!retry(batched_query_handle)) {
+                                complete(std::move(batched_query_handle));
+                            }
+                            worker.m_completed_query_count.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    }
+                }
             } else {
-                // Ran out of queries to execute, go back to sleep or exit if m_stop.
+                // Ran out of queries to execute, go back to sleep or exit if m_stop.  The cached
+                // connections stay warm across short idles and are reclaimed once idle too long.
+                if (!m_options.shared_nothing) {
+                    reclaim(worker);
+                }
+                break;
+            }
+        }
+    }
+
+    flush(worker);
+    mysql_thread_end();
+}
+
+auto Executor::execute(
+    Worker& worker,
+    QueryHandle query_handle) -> void
+{
+    auto& query = *query_handle;
+
+    // The other attempt of a hedged read already finished while this one was queued.
+    if (query.m_query_status == QueryStatus::BUILDING && query.m_hedge != nullptr) {
+        std::lock_guard<std::mutex> guard { query.m_hedge->m_lock };
+        if (query.m_hedge->m_finished) {
+            query.setError(QueryStatus::ERROR, "Hedged read cancelled, another attempt finished first");
+        }
+    }
+
+    // Only queries that check a connection out of the pool are admitted, the statements of a
+    // transaction already hold theirs.  A query parked by the concurrency limit was admitted
+    // by it once a slot freed up.
+    auto* limited_pool = std::exchange(query.m_limit_pool, nullptr);
+    bool circuit_admitted = false;
+    if (query.m_connection == nullptr && !admit(query_handle, limited_pool, circuit_admitted)) {
+        return;
+    }
+
+    // Cache hits, statements of broken transactions and queries failed by the circuit breaker
+    // or shed by the concurrency limit already have an outcome.
+    if (query.m_query_status == QueryStatus::BUILDING) {
+        if (query.m_connection == nullptr) {
+            // Statements of a transaction are handed their pinned connection, only its BEGIN
+            // checks one out of the pool.
+            query.m_connection = acquire(worker, *query.m_target_pool);
+            if (query.m_connection != nullptr && query.m_session != nullptr) {
+                query.m_connection->setReconnect(false);
+            }
+        }
+
+        if (query.m_connection != nullptr
+            && !query.m_options.consistency_token.empty()
+            && query.m_target_pool != &primary()) {
+            query.m_connection->setReadTimeout(query.m_timeout);
+            if (!query.m_connection->waitForGtids(query.m_options.consistency_token, m_options.consistency_wait)) {
+                // The replica hasn't applied the write in time, the primary always has.  A replica
+                // that couldn't be reached counts against it, one that is merely behind doesn't.
+                auto& replica_pool = *query.m_target_pool;
+                bool unreachable = query.m_connection->isBroken();
+                if (unreachable) {
+                    if (!m_replica_pools.empty()) {
+                        replica_pool.recordLatency(query.m_timeout, m_options.replica_latency_decay);
+                    }
+                    replica_pool.recordHealth(false, m_options.unhealthy_threshold);
+                    replica_pool.recordCircuit(false, circuit_admitted, m_options.circuit_breaker);
+                } else if (circuit_admitted) {
+                    replica_pool.circuitRelease(m_options.circuit_breaker);
+                }
+                circuit_admitted = false;
+                if (limited_pool != nullptr) {
+                    resume(unreachable
+                            ? limited_pool->recordLimit(query.m_timeout, true, m_options.concurrency_limit)
+                            : limited_pool->limitRelease(m_options.concurrency_limit));
+                    limited_pool = nullptr;
+                }
+                release(worker, std::move(query.m_connection));
+
+                query.m_target_pool = &primary();
+                if (!admit(query_handle, limited_pool, circuit_admitted)) {
+                    return;
+                }
+                if (query.m_query_status == QueryStatus::BUILDING) {
+                    query.m_connection = acquire(worker, *query.m_target_pool);
+                }
+            }
+        }
+
+        // Transaction statements execute on their pinned connection's server.
+        if (query.m_connection != nullptr) {
+            query.m_target_pool = &query.m_connection->m_query_pool;
+        }
+
+        // Latency and load only steer reads between replicas, a single server skips tracking them.
+        auto& target_pool = *query.m_target_pool;
+        bool balanced = !m_replica_pools.empty();
+        if (balanced) {
+            ++target_pool.m_executing;
+        }
+        auto started = std::chrono::steady_clock::now();
+
+        if (query.m_connection != nullptr) {
+            if (query.m_hedge != nullptr) {
+                startHedgeAttempt(query);
+            }
+            query.execute(*query.m_connection);
+        } else if (query.m_query_status == QueryStatus::BUILDING) {
+            query.setError(QueryStatus::CONNECT_FAILURE, "Timed out waiting for a pooled connection");
+        }
+
+        // Failed connects and lost connections are fast, they are penalized with the query's
+        // timeout so the balancer steers reads away from an unhealthy replica.  Running out of
+        // pooled connections says nothing about the server's health.
+        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+        bool unreachable = query.m_connection != nullptr
+            && (query.m_query_status == QueryStatus::CONNECT_FAILURE || query.m_connection->isBroken());
+        if (unreachable) {
+            latency = std::max<std::chrono::microseconds>(latency, query.m_timeout);
+        }
+        if (balanced) {
+            if (query.m_connection != nullptr) {
+                target_pool.recordLatency(latency, m_options.replica_latency_decay);
+            }
+            --target_pool.m_executing;
+        }
+        if (query.m_connection != nullptr) {
+            target_pool.recordHealth(!unreachable, m_options.unhealthy_threshold);
+            // Transaction statements on their pinned connection weren't admitted as probes.
+            target_pool.recordCircuit(!unreachable, circuit_admitted, m_options.circuit_breaker);
+        } else if (circuit_admitted) {
+            target_pool.circuitRelease(m_options.circuit_breaker);
+        }
+        if (limited_pool != nullptr && query.m_connection != nullptr) {
+            resume(limited_pool->recordLimit(latency, unreachable, m_options.concurrency_limit));
+            limited_pool = nullptr;
+        }
+
+        if (query.m_hedge != nullptr && query.m_connection != nullptr) {
+            finishHedgeAttempt(query);
+        }
+        if (m_hedge_thread.has_value()
+            && query.m_query_status == QueryStatus::SUCCESS
+            && query.m_session == nullptr
+            && query.isReplicaEligible()) {
+            recordReadLatency(latency);
+        }
+    }
+
+    // Admitted queries that never reached the server don't say anything about its limit.
+    if (limited_pool != nullptr) {
+        resume(limited_pool->limitRelease(m_options.concurrency_limit));
+    }
+
+    auto connection = std::move(query.m_connection);
+    if (query.m_session == nullptr) {
+        // The results are stored in the query, the connection can be re-used right away.
+        if (connection != nullptr) {
+            release(worker, std::move(connection));
+        }
+        if (retry(query_handle)) {
+            return;
+        }
+        complete(std::move(query_handle));
+    } else {
+        // The next statement of the transaction starts once this callback has returned.
+        auto session = query.m_session;
+        session->inspect(query, connection.get());
+        complete(std::move(query_handle));
+        session->release(std::move(connection));
+    }
+}
+
+auto Executor::admit(
+    QueryHandle& query_handle,
+    QueryPool*& limited_pool,
+    bool& circuit_admitted) -> bool
+{
+    auto& query = *query_handle;
+
+    // A query over the limit is parked on the pool instead of holding up this worker, it is
+    // queued again once a slot frees up or it is shed.
+    if (limited_pool == nullptr
+        && query.m_query_status == QueryStatus::BUILDING
+        && m_options.concurrency_limit.initial_limit > 0) {
+        switch (query.m_target_pool->limitAdmit(query_handle, m_options.concurrency_limit)) {
+            case QueryPool::LimitAdmit::ADMITTED:
+                limited_pool = query.m_target_pool;
+                break;
+            case QueryPool::LimitAdmit::PARKED:
+                parked();
+                return false;
+            case QueryPool::LimitAdmit::SHED:
+                query.setError(QueryStatus::OVERLOADED, "Concurrency limit reached, the server is overloaded");
+                break;
+        }
+    }
+
+    // The breaker may have opened while the query was queued, it fails fast instead of
+    // waiting for a connect timeout.  Only queries about to check a connection out of the pool
+    // take a half open breaker's probe slot, each one records its outcome or releases the slot.
+    if (query.m_query_status == QueryStatus::BUILDING) {
+        if (query.m_target_pool->circuitAdmit(m_options.circuit_breaker)) {
+            circuit_admitted = true;
+        } else {
+            query.setError(QueryStatus::CIRCUIT_OPEN, "Circuit breaker is open, the server is failing");
+        }
+    }
+
+    return true;
+}
+
+auto Executor::parked() -> void
+{
+    // The monitor sheds the query if no slot frees up within the max wait.
+    {
+        std::lock_guard<std::mutex> guard { m_monitor_mutex };
+        m_monitor_parked = true;
+    }
+    m_monitor_cv.notify_one();
+}
+
+auto Executor::resume(
+    std::vector<QueryHandle> query_handles) -> void
+{
+    // Parked queries already waited their turn, they go to the front of their queue.
+    for (auto& query_handle : query_handles) {
+        enqueue(std::move(query_handle), true);
+    }
+}
+
+auto Executor::acquire(
+    Worker& worker,
+    QueryPool& query_pool) -> std::unique_ptr<Connection>
+{
+    // The most recently cached connection to the server is the warmest.
+    auto& connections = worker.m_connections;
+    for (auto iter = connections.rbegin(); iter != connections.rend(); ++iter) {
+        if (&(*iter)->m_query_pool == &query_pool) {
+            auto connection = std::move(*iter);
+            connections.erase(std::next(iter).base());
+            worker.m_cached_connection_count.store(connections.size(), std::memory_order_relaxed);
+            return connection;
+        }
+    }
+
+    return query_pool.acquire();
+}
+
+auto Executor::release(
+    Worker& worker,
+    std::unique_ptr<Connection> connection) -> void
+{
+    auto& query_pool = connection->m_query_pool;
+    if (!query_pool.recycle(*connection)) {
+        return;
+    }
+
+    // A bounded pool at capacity needs every idle connection shared or other workers would
+    // fail to get one.
+    if (worker.m_connections.size() < m_options.worker_connection_cache_size && !query_pool.atCapacity()) {
+        worker.m_connections.emplace_back(std::move(connection));
+        worker.m_cached_connection_count.store(worker.m_connections.size(), std::memory_order_relaxed);
+    } else {
+        query_pool.store(std::move(connection));
+    }
+}
+
+auto Executor::flush(
+    Worker& worker) -> void
+{
+    for (auto& connection : worker.m_connections) {
+        auto& query_pool = connection->m_query_pool;
+        query_pool.store(std::move(connection));
+    }
+    worker.m_connections.clear();
+    worker.m_cached_connection_count.store(0, std::memory_order_relaxed);
+}
+
+auto Executor::reclaimTimeout() const -> std::chrono::milliseconds
+{
+    const auto& options = m_options.query_pool;
+    return (options.idle_timeout > std::chrono::milliseconds { 0 }) ? options.idle_timeout : options.maintenance_interval;
+}
+
+auto Executor::reclaim(
+    Worker& worker) -> void
+{
+    auto now = std::chrono::steady_clock::now();
+    auto reclaim_timeout = reclaimTimeout();
+
+    // Idle connections belong in the shared pool where they are maintained and other workers
+    // can use them, a bounded pool at capacity needs every idle connection shared right away.
+    auto& connections = worker.m_connections;
+    for (auto iter = connections.begin(); iter != connections.end();) {
+        if (now - (*iter)->m_idle_since >= reclaim_timeout || (*iter)->m_query_pool.atCapacity()) {
+            auto& query_pool = (*iter)->m_query_pool;
+            query_pool.store(std::move(*iter));
+            iter = connections.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    worker.m_cached_connection_count.store(connections.size(), std::memory_order_relaxed);
+}
+
+auto Executor::keepalive(
+    Worker& worker) -> void
+{
+    auto now = std::chrono::steady_clock::now();
+    auto keepalive_interval = m_options.query_pool.keepalive_interval;
+    if (keepalive_interval == std::chrono::milliseconds { 0 }) {
+        return;
+    }
+
+    auto& connections = worker.m_connections;
+    for (auto iter = connections.begin(); iter != connections.end();) {
+        auto& connection = *iter;
+        auto last_active = std::max(connection->m_idle_since, connection->m_pinged_at);
+        if (connection->m_is_connected && now - last_active >= keepalive_interval && !connection->ping()) {
+            iter = connections.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    worker.m_cached_connection_count.store(connections.size(), std::memory_order_relaxed);
+}
+
+auto Executor::executeGroupCommit(
+    Worker& worker,
+    std::vector<QueryHandle>& batch) -> void
+{
+    // Group commit writes always execute on the primary.  The batch takes a single concurrency
+    // limit slot and circuit breaker probe through its first write.
+    auto& query_pool = primary();
+    auto& leader = *batch.front();
+    auto* limited_pool = std::exchange(leader.m_limit_pool, nullptr);
+    bool circuit_admitted = false;
+    if (!admit(batch.front(), limited_pool, circuit_admitted)) {
+        // The other writes wait behind the parked one instead of executing ahead of it.
+        for (auto it = std::next(batch.begin()); it != batch.end(); ++it) {
+            switch (query_pool.limitAdmit(*it, m_options.concurrency_limit)) {
+                case QueryPool::LimitAdmit::ADMITTED:
+                    (*it)->m_limit_pool = &query_pool;
+                    enqueue(std::move(*it), true);
+                    break;
+                case QueryPool::LimitAdmit::PARKED:
+                    parked();
+                    break;
+                case QueryPool::LimitAdmit::SHED:
+                    (*it)->setError(QueryStatus::OVERLOADED, "Concurrency limit reached, the server is overloaded");
+                    break;
+            }
+        }
+        return;
+    }
+
+    // Shed by the concurrency limit or failed fast by the circuit breaker.
+    if (leader.m_query_status != QueryStatus::BUILDING) {
+        for (auto it = std::next(batch.begin()); it != batch.end(); ++it) {
+            (*it)->setError(leader.m_query_status, leader.m_error_message);
+        }
+        if (limited_pool != nullptr) {
+            resume(limited_pool->limitRelease(m_options.concurrency_limit));
+        }
+        return;
+    }
+
+    auto connection = acquire(worker, query_pool);
+    if (connection == nullptr) {
+        query_pool.circuitRelease(m_options.circuit_breaker);
+        if (limited_pool != nullptr) {
+            resume(limited_pool->limitRelease(m_options.concurrency_limit));
+        }
+        for (auto& query_handle : batch) {
+            query_handle->setError(QueryStatus::CONNECT_FAILURE, "Timed out waiting for a pooled connection");
+        }
+        return;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+
+    bool committed = false;
+    bool rolled_back = true;
+
+    // A silent reconnect between the writes would roll back the earlier writes and run the
+    // later ones in autocommit, the COMMIT would then succeed as a no-op.
+    connection->setReconnect(false);
+
+    if (connection->connect() && connection->executeControl("BEGIN")) {
+        bool writes_succeeded = true;
+        for (auto& query_handle : batch) {
+            if (query_handle->executeOn(connection->m_mysql) != QueryStatus::SUCCESS) {
+                writes_succeeded = false;
                 break;
             }
         }
+
+        if (writes_succeeded) {
+            if (connection->executeControl("COMMIT")) {
+                committed = true;
+                auto consistency_token = connection->trackedGtids();
+                for (auto& query_handle : batch) {
+                    query_handle->m_consistency_token = consistency_token;
+                }
+            } else {
+                // A server error on COMMIT rolls the transaction back, but if the connection was
+                // lost the outcome is unknown and re-executing the writes could apply them twice.
+                rolled_back = !connection->isBroken();
+            }
+        } else {
+            connection->executeControl("ROLLBACK");
+        }
     }
 
+    // The batch is a single query as far as the server's health is concerned.
+    bool unreachable = !connection->m_is_connected || connection->isBroken();
+    query_pool.recordHealth(!unreachable, m_options.unhealthy_threshold);
+    query_pool.recordCircuit(!unreachable, circuit_admitted, m_options.circuit_breaker);
+
+    // Writes executed individually reconnect like any other query.
+    connection->setReconnect(connection->m_connection_info.Options().auto_reconnect);
+
+    if (!committed) {
+        if (rolled_back) {
+            for (auto& query_handle : batch) {
+                query_handle->execute(*connection);
+            }
+        } else {
+            std::string error_message = "Group commit outcome unknown: ";
+            error_message.append(mysql_error(&connection->m_mysql));
+            auto error_number = mysql_errno(&connection->m_mysql);
+            for (auto& query_handle : batch) {
+                query_handle->setError(QueryStatus::ERROR, error_message, error_number);
+            }
+        }
+    }
+
+    if (limited_pool != nullptr) {
+        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+        resume(limited_pool->recordLimit(latency, unreachable, m_options.concurrency_limit));
+    }
+
+    release(worker, std::move(connection));
+}
+
+auto Executor::retry(
+    QueryHandle& query_handle) -> bool
+{
+    auto& query = *query_handle;
+    const auto& options = m_options.retry;
+    if (options.max_retries == 0 || query.m_retry_count >= options.max_retries || query.m_session != nullptr) {
+        return false;
+    }
+
+    if (query.m_hedge != nullptr) {
+        std::lock_guard<std::mutex> guard { query.m_hedge->m_lock };
+        if (query.m_hedge->m_finished) {
+            return false;
+        }
+    }
+
+    bool transient = false;
+    switch (query.m_error_number) {
+        case ER_LOCK_DEADLOCK:
+        case ER_LOCK_WAIT_TIMEOUT:
+            // The server rolled the statement back.
+            transient = true;
+            break;
+        case CR_SERVER_LOST:
+        case CR_SERVER_GONE_ERROR:
+            // The statement may or may not have been applied.
+            transient = query.isIdempotent();
+            break;
+        default:
+            break;
+    }
+
+    if (!transient) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard { m_retry_mutex };
+    if (m_stop || m_retry_budget < 1.0) {
+        return false;
+    }
+    m_retry_budget -= 1.0;
+
+    // Exponential backoff capped at the max, jittered between half and the full delay.
+    auto exponent = std::min<std::size_t>(query.m_retry_count, 20);
+    auto delay = std::min(options.backoff_initial * (int64_t { 1 } << exponent), options.backoff_max);
+    std::uniform_int_distribution<int64_t> jitter { delay.count() / 2, delay.count() };
+    auto retry_at = std::chrono::steady_clock::now() + std::chrono::milliseconds { jitter(m_retry_random) };
+
+    ++query.m_retry_count;
+    m_retries.emplace(retry_at, std::move(query_handle));
+    m_retry_cv.notify_one();
+    return true;
+}
+
+auto Executor::retrier() -> void
+{
+    std::unique_lock<std::mutex> lock { m_retry_mutex };
+    while (!m_stop) {
+        if (m_retries.empty()) {
+            m_retry_cv.wait(lock, [this]() { return m_stop || !m_retries.empty(); });
+            continue;
+        }
+
+        auto first = m_retries.begin();
+        if (std::chrono::steady_clock::now() < first->first) {
+            m_retry_cv.wait_until(lock, first->first);
+            continue;
+        }
+
+        auto query_handle = std::move(first->second);
+        m_retries.erase(first);
+
+        // A replica may have become healthier or unhealthier since the failed attempt.  Stop()
+        // sets m_stop under this lock, a retry queued while holding it is still seen by the
+        // workers before they exit.
+        query_handle->resetForRetry();
+        query_handle->m_target_pool = &route(*query_handle);
+        enqueue(std::move(query_handle));
+    }
+
+    auto retries = std::move(m_retries);
+    m_retries.clear();
+    lock.unlock();
+
+    for (auto& [retry_at, query_handle] : retries) {
+        (void)retry_at;
+        complete(std::move(query_handle));
+    }
+}
+
+auto Executor::hedgeDelay() -> std::optional<std::chrono::microseconds>
+{
+    std::lock_guard<std::mutex> guard { m_hedge_mutex };
+    return m_hedge_delay;
+}
+
+auto Executor::hedge(
+    QueryHandle& query_handle) -> void
+{
+    auto& query = *query_handle;
+    if (!m_hedge_thread.has_value()
+        || query.m_session != nullptr
+        || !query.isReplicaEligible()
+        || !query.isIdempotent()
+        || !hedgeDelay().has_value()) {
+        return;
+    }
+
+    // Calling new instead of std::make_shared since the ctor is private
+    auto hedged_read = std::shared_ptr<HedgedRead>(new HedgedRead());
+    hedged_read->m_on_complete = std::move(query.m_on_complete);
+
+    // The duplicate is prepared up front, the original's statement is in use once it executes.
+    auto duplicate = m_query_pool.Produce(query.m_statement, query.m_timeout, nullptr);
+    duplicate->m_options = query.m_options;
+    duplicate->m_statement_key = query.m_statement_key;
+    duplicate->m_hedge = hedged_read;
+    duplicate->m_hedged = true;
+
+    // The duplicate needs a different worker than the one executing the original.
+    hedged_read->m_duplicate_queue_index = (query.m_queue_index + 1) % m_queues.size();
+    hedged_read->m_duplicate.emplace(std::move(duplicate));
+    query.m_hedge = std::move(hedged_read);
+}
+
+auto Executor::startHedgeAttempt(
+    Query& query) -> void
+{
+    auto& connection = *query.m_connection;
+    connection.setReadTimeout(query.m_timeout);
+    unsigned long thread_id = connection.connect() ? mysql_thread_id(&connection.m_mysql) : 0;
+
+    auto& hedged_read = *query.m_hedge;
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> guard { hedged_read.m_lock };
+        query.m_hedge_attempt_id = ++hedged_read.m_last_attempt_id;
+        hedged_read.m_executing.push_back(HedgedRead::Attempt { query.m_hedge_attempt_id, query.m_target_pool, thread_id });
+        if (!query.m_hedged && !hedged_read.m_scheduled) {
+            hedged_read.m_scheduled = true;
+            schedule = true;
+        }
+    }
+
+    if (schedule) {
+        auto delay = hedgeDelay();
+        if (delay.has_value()) {
+            std::lock_guard<std::mutex> guard { m_hedge_mutex };
+            m_hedges.emplace(std::chrono::steady_clock::now() + delay.value(), query.m_hedge);
+            m_hedge_cv.notify_one();
+        }
+    }
+}
+
+auto Executor::finishHedgeAttempt(
+    Query& query) -> void
+{
+    auto& hedged_read = *query.m_hedge;
+    std::lock_guard<std::mutex> guard { hedged_read.m_lock };
+    auto& executing = hedged_read.m_executing;
+    auto found = std::find_if(executing.begin(), executing.end(), [&query](const HedgedRead::Attempt& attempt) {
+        return attempt.m_id == query.m_hedge_attempt_id;
+    });
+    if (found != executing.end()) {
+        executing.erase(found);
+    }
+}
+
+auto Executor::recordReadLatency(
+    std::chrono::microseconds latency) -> void
+{
+    const auto& options = m_options.hedge;
+    auto window = std::max<std::size_t>(options.window, 1);
+
+    std::lock_guard<std::mutex> guard { m_hedge_mutex };
+    if (m_hedge_samples.size() < window) {
+        m_hedge_samples.emplace_back(latency);
+    } else {
+        m_hedge_samples[m_hedge_sample_next] = latency;
+    }
+    m_hedge_sample_next = (m_hedge_sample_next + 1) % window;
+
+    // The percentile is re-computed every tenth of the window, it needs enough samples to
+    // have any reads above it.
+    if (++m_hedge_samples_pending < std::max<std::size_t>(window / 10, 1)) {
+        return;
+    }
+    auto min_samples = static_cast<std::size_t>(std::ceil(1.0 / std::max(1.0 - options.percentile, 0.001)));
+    if (m_hedge_samples.size() < min_samples) {
+        return;
+    }
+    m_hedge_samples_pending = 0;
+
+    auto samples = m_hedge_samples;
+    auto nth = std::min(samples.size() - 1, static_cast<std::size_t>(options.percentile * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + nth, samples.end());
+    m_hedge_delay = std::max<std::chrono::microseconds>(samples[nth], options.min_delay);
+}
+
+auto Executor::hedger() -> void
+{
+    mysql_thread_init();
+
+    std::unique_lock<std::mutex> lock { m_hedge_mutex };
+    while (!m_stop) {
+        if (!m_hedge_cancels.empty()) {
+            auto cancels = std::move(m_hedge_cancels);
+            m_hedge_cancels.clear();
+            lock.unlock();
+            for (auto& hedged_read : cancels) {
+                cancelHedge(*hedged_read);
+            }
+            lock.lock();
+            continue;
+        }
+
+        if (m_hedges.empty()) {
+            m_hedge_cv.wait(lock, [this]() { return m_stop || !m_hedges.empty() || !m_hedge_cancels.empty(); });
+            continue;
+        }
+
+        auto first = m_hedges.begin();
+        if (std::chrono::steady_clock::now() < first->first) {
+            m_hedge_cv.wait_until(lock, first->first);
+            continue;
+        }
+
+        auto hedged_read = std::move(first->second);
+        m_hedges.erase(first);
+        lock.unlock();
+        sendHedge(*hedged_read);
+        lock.lock();
+    }
+
+    // Unsent duplicates are dropped, their reads complete through the original attempt.
+    m_hedges.clear();
+    m_hedge_cancels.clear();
+    lock.unlock();
+
     mysql_thread_end();
 }
 
+auto Executor::sendHedge(
+    HedgedRead& hedged_read) -> void
+{
+    QueryHandle duplicate { nullptr };
+    {
+        std::lock_guard<std::mutex> guard { hedged_read.m_lock };
+        if (hedged_read.m_finished || !hedged_read.m_duplicate.has_value()) {
+            return;
+        }
+
+        // A replica the read is already executing on may be the slow one.
+        auto candidates = replicaCandidates(*hedged_read.m_duplicate.value());
+        for (const auto& attempt : hedged_read.m_executing) {
+            candidates.erase(std::remove(candidates.begin(), candidates.end(), attempt.m_query_pool), candidates.end());
+        }
+        if (candidates.empty()) {
+            return;
+        }
+
+        duplicate = std::move(hedged_read.m_duplicate.value());
+        hedged_read.m_duplicate.reset();
+        duplicate->m_target_pool = &balance(candidates.size(), [&candidates](std::size_t i) -> QueryPool& { return *candidates[i]; });
+        duplicate->m_queue_index = hedged_read.m_duplicate_queue_index;
+        ++hedged_read.m_outstanding;
+    }
+
+    // The duplicate's read starts now, it may only cache data that is at least this fresh.
+    if (m_result_cache != nullptr && duplicate->isCacheable()) {
+        duplicate->m_cache_epoch = m_result_cache->beginRead();
+        duplicate->m_cache_reading = true;
+    }
+
+    ++m_queues[duplicate->m_queue_index]->m_active_query_count;
+    enqueue(std::move(duplicate), true);
+}
+
+auto Executor::cancelHedge(
+    HedgedRead& hedged_read) -> void
+{
+    std::vector<HedgedRead::Attempt> attempts {};
+    {
+        std::lock_guard<std::mutex> guard { hedged_read.m_lock };
+        attempts = hedged_read.m_executing;
+    }
+
+    for (const auto& attempt : attempts) {
+        if (attempt.m_thread_id == 0) {
+            continue;
+        }
+
+        // A kill waits at most a second on the slow server so one cancel can't stall the
+        // hedger's sends.
+        auto& connection = m_kill_connections[attempt.m_query_pool];
+        if (connection == nullptr) {
+            connection = attempt.m_query_pool->controlConnection();
+            connection->setConnectTimeout(std::chrono::seconds { 1 });
+            connection->setReadTimeout(std::chrono::seconds { 1 });
+            connection->setReconnect(false);
+        }
+
+        if (connection->connect()) {
+            // The attempt unregisters before its connection is released, while it is still
+            // registered its connection can only be executing the losing attempt.
+            std::lock_guard<std::mutex> guard { hedged_read.m_lock };
+            auto& executing = hedged_read.m_executing;
+            bool still_executing = std::any_of(executing.begin(), executing.end(), [&attempt](const HedgedRead::Attempt& other) {
+                return other.m_id == attempt.m_id;
+            });
+            if (still_executing) {
+                connection->executeControl("KILL QUERY " + std::to_string(attempt.m_thread_id));
+            }
+        }
+        if (!connection->m_is_connected || connection->isBroken()) {
+            // Reconnected on the next cancel.
+            connection = nullptr;
+        }
+    }
+}
+
+auto Executor::complete(
+    QueryHandle query_handle) -> void
+{
+    if (m_result_cache != nullptr) {
+        if (query_handle->m_cache_reading) {
+            if (!query_handle->m_from_cache && query_handle->m_query_status == QueryStatus::SUCCESS) {
+                m_result_cache->insert(*query_handle);
+            }
+            m_result_cache->endRead(query_handle->m_cache_epoch);
+            query_handle->m_cache_reading = false;
+        } else if (query_handle->m_session != nullptr) {
+            auto tags = query_handle->m_session->collectCacheTags(*query_handle);
+            if (tags.has_value()) {
+                m_result_cache->invalidateTags(tags.value());
+            }
+        } else if (query_handle->isWrite()) {
+            // Invalidate even if the write failed, e.g. a lost connection can't tell if it applied.
+            m_result_cache->invalidate(*query_handle);
+        }
+    }
+
+    std::vector<QueryHandle> followers {};
+    if (query_handle->m_leads_single_flight) {
+        {
+            std::lock_guard<std::mutex> g { m_single_flight_mutex };
+            auto found = m_single_flights.find(query_handle->m_statement_key);
+            followers = std::move(found->second);
+            m_single_flights.erase(found);
+        }
+
+        for (auto& follower : followers) {
+            follower->shareResult(*query_handle);
+            if (follower->m_cache_reading) {
+                m_result_cache->endRead(follower->m_cache_epoch);
+                follower->m_cache_reading = false;
+            }
+        }
+    }
+
+    auto& queue = *m_queues[query_handle->m_queue_index];
+
+    if (query_handle->m_hedge != nullptr) {
+        auto& hedged_read = *query_handle->m_hedge;
+        std::optional<QueryHandle> duplicate {};
+        bool cancel = false;
+        {
+            // The first attempt to succeed wins, a failed attempt only completes the read if
+            // no other attempt can still succeed.
+            std::lock_guard<std::mutex> guard { hedged_read.m_lock };
+            --hedged_read.m_outstanding;
+            if (!hedged_read.m_finished
+                && (query_handle->m_query_status == QueryStatus::SUCCESS || hedged_read.m_outstanding == 0)) {
+                hedged_read.m_finished = true;
+                query_handle->m_on_complete = std::move(hedged_read.m_on_complete);
+                duplicate.swap(hedged_read.m_duplicate);
+                cancel = !hedged_read.m_executing.empty();
+            }
+        }
+
+        if (cancel) {
+            std::lock_guard<std::mutex> guard { m_hedge_mutex };
+            m_hedge_cancels.emplace_back(query_handle->m_hedge);
+            m_hedge_cv.notify_one();
+        }
+
+        // The losing attempt is dropped.
+        if (query_handle->m_on_complete == nullptr) {
+            --queue.m_active_query_count;
+            return;
+        }
+    }
+
+    auto on_complete = std::move(query_handle->m_on_complete);
+    on_complete(std::move(query_handle));
+    --queue.m_active_query_count;
+
+    for (auto& follower : followers) {
+        auto& follower_queue = *m_queues[follower->m_queue_index];
+        auto follower_on_complete = std::move(follower->m_on_complete);
+        follower_on_complete(std::move(follower));
+        --follower_queue.m_active_query_count;
+    }
+}
+
 } // namespace wing
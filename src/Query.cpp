@@ -4,16 +4,16 @@
 
 #include <mysql/mysql.h>
 
+#include <algorithm>
+#include <cctype>
 #include <sstream>
 #include <stdexcept>
 
 namespace wing {
 
-Query::~Query()
-{
-    reset();
-    mysql_close(&m_mysql);
-}
+static const std::vector<wing::Row> g_empty_rows {};
+
+Query::~Query() = default;
 
 auto Query::QueryStatus() const -> wing::QueryStatus
 {
@@ -28,7 +28,7 @@ auto Query::QueryOriginal() const -> const std::string&
 auto Query::Error() const -> std::optional<std::string>
 {
     if (m_had_error) {
-        return { mysql_error(&m_mysql) };
+        return { m_error_message };
     } else {
         return {};
     }
@@ -53,74 +53,62 @@ auto Query::RowCount() const -> size_t
 
 auto Query::Row(size_t idx) const -> const wing::Row&
 {
-    return m_rows.at(idx);
+    return Rows().at(idx);
+}
+
+auto Query::Rows() const -> const std::vector<wing::Row>&
+{
+    return (m_result_set != nullptr) ? m_result_set->Rows() : g_empty_rows;
 }
 
 Query::Query(
-    QueryPool& query_pool,
-    const ConnectionInfo& connection,
     std::function<void(QueryHandle)> on_complete,
     std::chrono::milliseconds timeout,
     wing::Statement statement)
-    : m_query_pool(query_pool)
-    , m_connection(connection)
-    , m_on_complete(std::move(on_complete))
+    : m_on_complete(std::move(on_complete))
     , m_timeout(timeout)
     , m_statement(std::move(statement))
 {
-    mysql_init(&m_mysql);
-
-    this->timeout();
+}
 
-    unsigned int connect_timeout = 1;
-    mysql_options(&m_mysql, MYSQL_OPT_CONNECT_TIMEOUT, &connect_timeout);
+auto Query::execute(
+    Connection& connection) -> wing::QueryStatus
+{
+    connection.setReadTimeout(m_timeout);
 
-    uint64_t auto_reconnect = 1;
-    mysql_options(&m_mysql, MYSQL_OPT_RECONNECT, &auto_reconnect);
+    if (!connection.connect()) {
+        if (connection.m_connect_throttled) {
+            setError(QueryStatus::CONNECT_FAILURE, "Not connecting, backing off after repeated connect failures");
+        } else {
+            setError(QueryStatus::CONNECT_FAILURE, connection.m_mysql);
+        }
+        return m_query_status;
+    }
 
-#ifdef WING_MYSQL_OPT_SSL_ENFORCE_DISABLED
-    bool ssl = false;
-    mysql_options(&m_mysql, MYSQL_OPT_SSL_ENFORCE, &ssl);
-#endif
+    if (connection.m_query_pool.Options().reset_policy == ConnectionResetPolicy::ON_SESSION_CHANGE
+        && !connection.m_session_changed && changesSession()) {
+        connection.m_session_changed = true;
+    }
 
-    //  Some mysql libraries do not support SSL_MODE_DISABLED
-#ifdef WING_PERCONA_SSL_DISABLED
-    uint32_t ssl_mode = SSL_MODE_DISABLED;
-    mysql_options(&m_mysql, MYSQL_OPT_SSL_MODE, &ssl_mode);
-#endif
+    if (executeOn(connection.m_mysql) == QueryStatus::SUCCESS) {
+        m_consistency_token = connection.trackedGtids();
+    }
+    connection.refreshSocketOptions();
+    return m_query_status;
 }
 
-auto Query::reset() -> void
+auto Query::executeOn(
+    MYSQL& mysql) -> wing::QueryStatus
 {
     freeResult();
-    m_statement = wing::Statement {};
-    m_query_status = QueryStatus::BUILDING;
     m_had_error = false;
-}
-
-auto Query::timeout() -> void
-{
-    auto timeout_seconds = std::chrono::duration_cast<std::chrono::seconds>(m_timeout);
-    unsigned int read_timeout = static_cast<unsigned int>(timeout_seconds.count());
-    mysql_options(&m_mysql, MYSQL_OPT_READ_TIMEOUT, &read_timeout);
-}
-
-auto Query::execute() -> wing::QueryStatus
-{
-    if (!m_is_connected) {
-        if (!connect()) {
-            m_query_status = QueryStatus::CONNECT_FAILURE;
-            m_had_error = true;
-            return m_query_status;
-        }
-    }
-
-    freeResult();
+    m_error_message.clear();
+    m_error_number = 0;
 
     try {
         // ask the statement to prepare the final query string
         m_final_statement = m_statement.prepareStatement(
-            [this](const std::string& str_value) {
+            [&mysql](const std::string& str_value) {
                 if (str_value.empty()) {
                     throw std::invalid_argument("Empty statement part passed in to prepareStatement");
                 }
@@ -128,90 +116,162 @@ auto Query::execute() -> wing::QueryStatus
                 std::string buffer;
                 buffer.resize(str_value.length() * 2 + 1);
 
-                size_t length = mysql_real_escape_string(&m_mysql, buffer.data(), &str_value.front(), str_value.length());
+                size_t length = mysql_real_escape_string(&mysql, buffer.data(), &str_value.front(), str_value.length());
                 buffer.resize(length);
 
                 return buffer;
             });
     } catch (const std::invalid_argument& e) {
-        m_query_status = QueryStatus::INVALID;
-        m_had_error = true;
+        setError(QueryStatus::INVALID, e.what());
         return m_query_status;
     }
 
-    if (0 == mysql_real_query(&m_mysql, m_final_statement.c_str(), m_final_statement.length())) {
-        m_result = mysql_store_result(&m_mysql);
-        if (m_result != nullptr) {
+    if (0 == mysql_real_query(&mysql, m_final_statement.c_str(), m_final_statement.length())) {
+        auto* result = mysql_store_result(&mysql);
+        if (result != nullptr) {
             m_query_status = QueryStatus::SUCCESS;
-            m_field_count = mysql_num_fields(m_result);
-            m_row_count = mysql_num_rows(m_result);
-            parseRows();
+            // Calling new instead of std::make_shared since the ctor is private
+            m_result_set = std::shared_ptr<const ResultSet>(new ResultSet(result));
+            m_field_count = m_result_set->FieldCount();
+            m_row_count = m_result_set->RowCount();
         } else {
             // Use this function to determine if the query should have returned values
-            if (mysql_field_count(&m_mysql) == 0) {
+            if (mysql_field_count(&mysql) == 0) {
                 m_query_status = QueryStatus::SUCCESS;
                 m_field_count = 0;
-                m_row_count = mysql_affected_rows(&m_mysql);
-                m_parsed_result = true;
+                m_row_count = mysql_affected_rows(&mysql);
             } else {
-                m_query_status = QueryStatus::ERROR;
-                m_had_error = true;
+                setError(QueryStatus::ERROR, mysql);
             }
         }
+        m_last_insert_id = mysql_insert_id(&mysql);
     } else {
-        m_query_status = QueryStatus::ERROR;
-        m_had_error = true;
+        setError(QueryStatus::ERROR, mysql);
     }
     return m_query_status;
 }
 
-auto Query::connect() -> bool
+auto Query::setError(
+    wing::QueryStatus status,
+    std::string message,
+    unsigned int error_number) -> void
+{
+    m_query_status = status;
+    m_had_error = true;
+    m_error_message = std::move(message);
+    m_error_number = error_number;
+}
+
+auto Query::setError(
+    wing::QueryStatus status,
+    MYSQL& mysql) -> void
 {
-    if (!m_is_connected) {
-        auto* success = mysql_real_connect(
-            &m_mysql,
-            m_connection.Host().c_str(),
-            m_connection.User().c_str(),
-            m_connection.Password().c_str(),
-            m_connection.Database().c_str(),
-            m_connection.Port(),
-            m_connection.Socket().c_str(),
-            m_connection.ClientFlags());
+    setError(status, mysql_error(&mysql), mysql_errno(&mysql));
+}
 
-        if (success == nullptr) {
+auto Query::changesSession() const -> bool
+{
+    // A Transaction's BEGIN always ends with its COMMIT or ROLLBACK, it leaves nothing behind.
+    if (m_session != nullptr && m_statement.leadingKeyword() == "BEGIN") {
+        return false;
+    }
+
+    return m_statement.changesSession();
+}
+
+auto Query::isGroupCommitEligible() const -> bool
+{
+    // Queries that already have an outcome, e.g. from the circuit breaker, are never executed.
+    return m_options.group_commit && m_query_status == QueryStatus::BUILDING && m_statement.isDml();
+}
+
+auto Query::isSingleFlightEligible() const -> bool
+{
+    // A read bounded by a write or a staleness could otherwise share the result of a read that
+    // started before the write or executes on a lagging replica.
+    return m_options.single_flight
+        && m_statement.isRead()
+        && m_options.consistency_token.empty()
+        && m_options.max_staleness == std::chrono::milliseconds { 0 };
+}
+
+auto Query::isCacheable() const -> bool
+{
+    return m_options.cache_ttl > std::chrono::milliseconds { 0 } && m_statement.isRead();
+}
+
+auto Query::isIdempotent() const -> bool
+{
+    return m_options.idempotent || !m_statement.isWrite();
+}
+
+auto Query::resetForRetry() -> void
+{
+    freeResult();
+    m_query_status = QueryStatus::BUILDING;
+    m_had_error = false;
+    m_error_message.clear();
+    m_error_number = 0;
+    m_consistency_token.clear();
+}
+
+auto Query::isReplicaEligible() const -> bool
+{
+    switch (m_options.route) {
+        case QueryRoute::PRIMARY:
             return false;
-        }
+        case QueryRoute::REPLICA:
+            return true;
+        case QueryRoute::AUTO:
+            break;
+    }
 
-        m_is_connected = true;
+    return m_statement.isRead() && !m_statement.isLockingRead() && !m_statement.changesSession();
+}
+
+auto Query::cacheTags() const -> std::vector<std::string>
+{
+    auto tags = m_statement.tables();
+    for (const auto& tag : m_options.cache_tags) {
+        tags.emplace_back(normalizeCacheTag(tag));
     }
 
-    return true;
+    std::sort(tags.begin(), tags.end());
+    tags.erase(std::unique(tags.begin(), tags.end()), tags.end());
+    return tags;
 }
 
-auto Query::parseRows() -> void
+auto Query::normalizeCacheTag(
+    std::string tag) -> std::string
 {
-    if (!m_parsed_result && RowCount() > 0) {
-        m_parsed_result = true;
-        m_rows.reserve(RowCount());
-        MYSQL_ROW mysql_row = nullptr;
-        while ((mysql_row = mysql_fetch_row(m_result))) {
-            auto lengths = mysql_fetch_lengths(m_result);
-            wing::Row row(mysql_row, m_field_count, lengths);
-            m_rows.emplace_back(std::move(row));
-        }
+    tag.erase(std::remove(tag.begin(), tag.end(), '`'), tag.end());
+    auto qualifier = tag.rfind('.');
+    if (qualifier != std::string::npos) {
+        tag.erase(0, qualifier + 1);
     }
+    std::transform(tag.begin(), tag.end(), tag.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return tag;
+}
+
+auto Query::shareResult(
+    const Query& from) -> void
+{
+    m_query_status = from.m_query_status;
+    m_had_error = from.m_had_error;
+    m_error_message = from.m_error_message;
+    m_error_number = from.m_error_number;
+    m_last_insert_id = from.m_last_insert_id;
+    m_final_statement = from.m_final_statement;
+    m_result_set = from.m_result_set;
+    m_field_count = from.m_field_count;
+    m_row_count = from.m_row_count;
 }
 
 auto Query::freeResult() -> void
 {
-    if (m_result != nullptr) {
-        mysql_free_result(m_result);
-        m_parsed_result = false;
-        m_field_count = 0;
-        m_row_count = 0;
-        m_rows.clear();
-        m_result = nullptr;
-    }
+    m_result_set.reset();
+    m_field_count = 0;
+    m_row_count = 0;
 }
 
 } // wing
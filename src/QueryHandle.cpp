@@ -1,5 +1,4 @@
 #include "wing/QueryHandle.hpp"
-#include "wing/QueryPool.hpp"
 
 namespace wing {
 
@@ -9,13 +8,7 @@ QueryHandle::QueryHandle(
 {
 }
 
-QueryHandle::~QueryHandle()
-{
-    if (query_ptr != nullptr) {
-        QueryPool& query_pool = query_ptr->m_query_pool;
-        query_pool.returnQuery(std::move(query_ptr));
-    }
-}
+QueryHandle::~QueryHandle() = default;
 
 QueryHandle::QueryHandle(QueryHandle&& from)
     : query_ptr(std::move(from.query_ptr))
@@ -24,7 +17,9 @@ QueryHandle::QueryHandle(QueryHandle&& from)
 
 auto QueryHandle::operator=(QueryHandle&& from) noexcept -> QueryHandle&
 {
-    query_ptr = std::move(from.query_ptr);
+    if (this != &from) {
+        query_ptr = std::move(from.query_ptr);
+    }
     return *this;
 }
 
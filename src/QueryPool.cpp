@@ -1,10 +1,29 @@
 #include "wing/QueryPool.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 namespace wing {
 
 QueryPool::~QueryPool()
 {
-    m_queries.clear();
+    m_stop = true;
+    m_maintenance_cv.notify_all();
+    if (m_maintenance_thread.has_value()) {
+        m_maintenance_thread.value().join();
+    }
+
+    {
+        // Notified under the lock so a connector can't miss the stop between its check and wait.
+        std::lock_guard<std::mutex> guard { m_lock };
+        m_connector_cv.notify_all();
+    }
+    for (auto& connector_thread : m_connector_threads) {
+        connector_thread.join();
+    }
+
+    clear();
 }
 
 auto QueryPool::Produce(
@@ -19,60 +38,739 @@ auto QueryPool::Produce(
     std::chrono::milliseconds timeout,
     std::function<void(QueryHandle)> on_complete) -> QueryHandle
 {
-    m_lock.lock();
-    if (m_queries.empty()) {
-        m_lock.unlock();
-        return QueryHandle(
+    return QueryHandle(
+        // Calling new instead of std::make_unique since the ctor is private
+        std::unique_ptr<Query>(
+            new Query(
+                std::move(on_complete),
+                timeout,
+                std::move(statement))));
+}
+
+auto QueryPool::clear() -> void
+{
+    std::deque<std::unique_ptr<wing::Connection>> connections {};
+    std::deque<std::unique_ptr<wing::Connection>> failed_connections {};
+    {
+        std::lock_guard<std::mutex> guard { m_lock };
+        connections.swap(m_connections);
+        failed_connections.swap(m_failed_connections);
+    }
+    // Closed outside the lock, each connection reports its destruction to the pool.
+}
+
+QueryPool::QueryPool(
+    ConnectionInfo connection,
+    QueryPoolOptions options,
+    std::string session_init)
+    : m_connection(std::move(connection))
+    , m_options(std::move(options))
+    , m_session_init(std::move(session_init))
+{
+    if (m_options.min_idle > 0
+        || m_options.keepalive_interval > std::chrono::milliseconds { 0 }
+        || m_options.idle_timeout > std::chrono::milliseconds { 0 }
+        || m_options.max_lifetime > std::chrono::milliseconds { 0 }) {
+        m_maintenance_thread.emplace([this]() { maintenance(); });
+    }
+
+    m_connector_threads.reserve(m_options.background_connectors);
+    for (std::size_t i = 0; i < m_options.background_connectors; ++i) {
+        m_connector_threads.emplace_back([this]() { connector(); });
+    }
+}
+
+auto QueryPool::acquire() -> std::unique_ptr<wing::Connection>
+{
+    std::unique_lock<std::mutex> lock { m_lock };
+
+    if (m_options.background_connectors > 0) {
+        return acquireBackground(lock);
+    }
+
+    auto has_capacity = [this]() {
+        return !m_connections.empty() || m_options.max_connections == 0 || m_total < m_options.max_connections;
+    };
+
+    if (!has_capacity()) {
+        if (m_options.max_wait <= std::chrono::milliseconds { 0 }
+            || !m_wait_cv.wait_for(lock, m_options.max_wait, has_capacity)) {
+            return nullptr;
+        }
+    }
+
+    if (m_connections.empty()) {
+        ++m_total;
+        lock.unlock();
+        // Calling new instead of std::make_unique since the ctor is private
+        return std::unique_ptr<wing::Connection>(new wing::Connection(*this, m_connection));
+    }
+
+    auto connection = std::move(m_connections.back());
+    m_connections.pop_back();
+    return connection;
+}
+
+auto QueryPool::acquireBackground(
+    std::unique_lock<std::mutex>& lock) -> std::unique_ptr<wing::Connection>
+{
+    auto deadline = std::chrono::steady_clock::now() + m_options.max_wait;
+
+    while (true) {
+        if (!m_connections.empty()) {
+            auto connection = std::move(m_connections.back());
+            m_connections.pop_back();
+            return connection;
+        }
+
+        if (!m_failed_connections.empty()) {
+            auto connection = std::move(m_failed_connections.front());
+            m_failed_connections.pop_front();
+            return connection;
+        }
+
+        // Connections being connected in the background already count towards the total.
+        bool can_grow = m_options.max_connections == 0 || m_total < m_options.max_connections;
+        if (can_grow) {
+            // Every waiting worker has one connect requested on its behalf, whichever connection
+            // is ready first is taken and a surplus connection is simply left idle.
+            if (m_connect_requests + m_background_connecting < m_acquirers_waiting + 1) {
+                ++m_connect_requests;
+                ++m_total;
+                m_connector_cv.notify_one();
+            }
+
+            ++m_acquirers_waiting;
+            m_wait_cv.wait(lock);
+            --m_acquirers_waiting;
+        } else {
+            if (m_options.max_wait <= std::chrono::milliseconds { 0 }) {
+                return nullptr;
+            }
+
+            ++m_acquirers_waiting;
+            auto status = m_wait_cv.wait_until(lock, deadline);
+            --m_acquirers_waiting;
+            if (status == std::cv_status::timeout && m_connections.empty() && m_failed_connections.empty()) {
+                return nullptr;
+            }
+        }
+    }
+}
+
+auto QueryPool::release(
+    std::unique_ptr<wing::Connection> connection) -> void
+{
+    if (recycle(*connection)) {
+        store(std::move(connection));
+    }
+}
+
+auto QueryPool::recycle(
+    wing::Connection& connection) -> bool
+{
+    // Only close the connection if an error broke it, SQL errors leave it usable.
+    if (connection.isBroken() || connection.m_connect_failed) {
+        return false;
+    }
+
+    // Expired connections are closed rather than re-used.
+    if (expired(connection, std::chrono::steady_clock::now())) {
+        return false;
+    }
+
+    // Resetting the session is a single round trip, far cheaper than reconnecting.
+    if (!connection.resetSession(m_options.reset_policy)) {
+        return false;
+    }
+
+    connection.m_idle_since = std::chrono::steady_clock::now();
+    return true;
+}
+
+auto QueryPool::store(
+    std::unique_ptr<wing::Connection> connection) -> void
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_connections.emplace_back(std::move(connection));
+    }
+
+    m_wait_cv.notify_one();
+}
+
+auto QueryPool::controlConnection() -> std::unique_ptr<wing::Connection>
+{
+    // Calling new instead of std::make_unique since the ctor is private
+    auto connection = std::unique_ptr<wing::Connection>(new wing::Connection(*this, m_connection));
+    connection->m_pooled = false;
+    return connection;
+}
+
+auto QueryPool::connectionDestroyed() -> void
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        --m_total;
+    }
+
+    m_wait_cv.notify_one();
+}
+
+auto QueryPool::beginConnect() -> bool
+{
+    std::unique_lock<std::mutex> lock { m_lock };
+
+    auto backing_off = [this]() {
+        return m_options.connect_backoff_initial > std::chrono::milliseconds { 0 }
+            && std::chrono::steady_clock::now() < m_connect_backoff_until;
+    };
+
+    if (backing_off()) {
+        return false;
+    }
+
+    if (m_options.max_concurrent_connects > 0) {
+        m_connect_cv.wait(lock, [this]() { return m_connecting < m_options.max_concurrent_connects; });
+
+        // An attempt that finished while waiting may have failed.
+        if (backing_off()) {
+            return false;
+        }
+    }
+
+    ++m_connecting;
+    return true;
+}
+
+auto QueryPool::endConnect(
+    bool connected) -> void
+{
+    {
+        std::lock_guard<std::mutex> guard { m_lock };
+        --m_connecting;
+
+        if (connected) {
+            m_connect_failures = 0;
+        } else if (m_options.connect_backoff_initial > std::chrono::milliseconds { 0 }) {
+            // Exponential backoff capped at the max, jittered between half and the full delay.
+            ++m_connect_failures;
+            auto exponent = std::min<std::size_t>(m_connect_failures - 1, 20);
+            auto delay = std::min(m_options.connect_backoff_initial * (int64_t { 1 } << exponent), m_options.connect_backoff_max);
+            std::uniform_int_distribution<int64_t> jitter { delay.count() / 2, delay.count() };
+            m_connect_backoff_until = std::chrono::steady_clock::now() + std::chrono::milliseconds { jitter(m_random) };
+        }
+    }
+
+    m_connect_cv.notify_one();
+}
+
+auto QueryPool::expired(
+    const wing::Connection& connection,
+    std::chrono::steady_clock::time_point now) const -> bool
+{
+    return m_options.max_lifetime > std::chrono::milliseconds { 0 }
+        && connection.m_is_connected
+        && now - connection.m_connected_at >= m_options.max_lifetime;
+}
+
+auto QueryPool::maintenance() -> void
+{
+    mysql_thread_init();
+
+    while (!m_stop) {
+        {
+            std::unique_lock<std::mutex> lock { m_lock };
+            m_maintenance_cv.wait_for(lock, m_options.maintenance_interval, [this]() { return m_stop.load(); });
+        }
+
+        if (m_stop) {
+            break;
+        }
+
+        // Close idle connections past their idle timeout or lifetime, the least recently
+        // returned connections are at the front of the idle queue.
+        std::vector<std::unique_ptr<wing::Connection>> closing {};
+        {
+            std::lock_guard<std::mutex> guard { m_lock };
+            auto now = std::chrono::steady_clock::now();
+            for (auto iter = m_connections.begin(); iter != m_connections.end();) {
+                auto& connection = *iter;
+                bool idle_too_long = m_options.idle_timeout > std::chrono::milliseconds { 0 }
+                    && m_connections.size() > m_options.min_idle
+                    && now - connection->m_idle_since >= m_options.idle_timeout;
+
+                if (idle_too_long || expired(*connection, now)) {
+                    closing.emplace_back(std::move(connection));
+                    iter = m_connections.erase(iter);
+                } else {
+                    ++iter;
+                }
+            }
+        }
+        closing.clear();
+
+        // Dead connections found by the keepalive are replaced even beyond the min idle.
+        auto replacements = keepalive();
+
+        // Connect new idle connections up to the min idle, connecting happens outside the lock.
+        while (!m_stop) {
+            {
+                std::lock_guard<std::mutex> guard { m_lock };
+                if ((m_connections.size() >= m_options.min_idle && replacements == 0)
+                    || (m_options.max_connections > 0 && m_total >= m_options.max_connections)) {
+                    break;
+                }
+                ++m_total;
+            }
+
+            if (replacements > 0) {
+                --replacements;
+            }
+
             // Calling new instead of std::make_unique since the ctor is private
-            std::unique_ptr<Query>(
-                new Query(
-                    *this,
-                    m_connection,
-                    std::move(on_complete),
-                    timeout,
-                    std::move(statement))));
+            auto connection = std::unique_ptr<wing::Connection>(new wing::Connection(*this, m_connection));
+            if (!connection->connect()) {
+                break;
+            }
+
+            connection->m_idle_since = std::chrono::steady_clock::now();
+            connection->m_pinged_at = connection->m_idle_since;
+            {
+                std::lock_guard<std::mutex> guard { m_lock };
+                m_connections.emplace_front(std::move(connection));
+            }
+            m_wait_cv.notify_one();
+        }
+    }
+
+    mysql_thread_end();
+}
+
+auto QueryPool::recordLatency(
+    std::chrono::microseconds latency,
+    std::chrono::milliseconds decay) -> void
+{
+    auto now = std::chrono::steady_clock::now();
+    auto sample = static_cast<double>(latency.count());
+
+    std::lock_guard<std::mutex> guard { m_stats_lock };
+    if (sample > m_latency_average) {
+        m_latency_average = sample;
     } else {
-        auto request_handle_ptr = std::move(m_queries.back());
-        m_queries.pop_back();
-        m_lock.unlock();
+        std::chrono::duration<double, std::milli> elapsed = now - m_latency_updated_at;
+        auto weight = std::exp(-elapsed.count() / std::max<double>(decay.count(), 1.0));
+        m_latency_average = m_latency_average * weight + sample * (1.0 - weight);
+    }
+    m_latency_updated_at = now;
+}
 
-        request_handle_ptr->m_on_complete = std::move(on_complete);
-        request_handle_ptr->m_timeout = timeout;
-        request_handle_ptr->timeout();
-        request_handle_ptr->m_statement = std::move(statement);
+auto QueryPool::loadCost(
+    std::chrono::milliseconds decay) -> double
+{
+    auto now = std::chrono::steady_clock::now();
+    double average = 0.0;
+    {
+        std::lock_guard<std::mutex> guard { m_stats_lock };
+        std::chrono::duration<double, std::milli> elapsed = now - m_latency_updated_at;
+        average = m_latency_average * std::exp(-elapsed.count() / std::max<double>(decay.count(), 1.0));
+    }
 
-        return QueryHandle(std::move(request_handle_ptr));
+    return average * static_cast<double>(m_executing.load(std::memory_order_relaxed) + 1);
+}
+
+auto QueryPool::recordHealth(
+    bool succeeded,
+    std::size_t unhealthy_threshold) -> void
+{
+    // Every query records its outcome, only writing on a change keeps the cache line shared.
+    if (succeeded) {
+        if (m_consecutive_failures.load(std::memory_order_relaxed) != 0) {
+            m_consecutive_failures.store(0, std::memory_order_relaxed);
+        }
+        if (!m_healthy.load(std::memory_order_relaxed)) {
+            m_healthy.store(true, std::memory_order_relaxed);
+        }
+    } else if (unhealthy_threshold > 0 && ++m_consecutive_failures >= unhealthy_threshold
+        && m_healthy.load(std::memory_order_relaxed)) {
+        m_healthy.store(false, std::memory_order_relaxed);
     }
 }
 
-QueryPool::QueryPool(
-    ConnectionInfo connection)
-    : m_connection(std::move(connection))
+auto QueryPool::circuitAdmit(
+    const CircuitBreakerOptions& options) -> bool
+{
+    if (options.failure_ratio <= 0.0) {
+        return true;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> guard { m_stats_lock };
+    switch (m_circuit_state) {
+        case CircuitState::CLOSED:
+            return true;
+        case CircuitState::OPEN:
+            if (now - m_circuit_opened_at < options.cool_down) {
+                return false;
+            }
+            m_circuit_state = CircuitState::HALF_OPEN;
+            m_circuit_half_opened_at = now;
+            m_circuit_probes_admitted = 0;
+            m_circuit_probes_succeeded = 0;
+            [[fallthrough]];
+        case CircuitState::HALF_OPEN:
+            if (m_circuit_probes_admitted >= std::max<std::size_t>(options.half_open_queries, 1)) {
+                // Probes that take this long are as good as failed.
+                auto timeout = (options.half_open_timeout > std::chrono::milliseconds { 0 }) ? options.half_open_timeout : options.cool_down;
+                if (now - m_circuit_half_opened_at >= timeout) {
+                    m_circuit_state = CircuitState::OPEN;
+                    m_circuit_opened_at = now;
+                }
+                return false;
+            }
+            ++m_circuit_probes_admitted;
+            return true;
+    }
+
+    return true;
+}
+
+auto QueryPool::circuitRelease(
+    const CircuitBreakerOptions& options) -> void
+{
+    if (options.failure_ratio <= 0.0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard { m_stats_lock };
+    if (m_circuit_state == CircuitState::HALF_OPEN && m_circuit_probes_admitted > m_circuit_probes_succeeded) {
+        --m_circuit_probes_admitted;
+    }
+}
+
+auto QueryPool::circuitOpen(
+    const CircuitBreakerOptions& options) -> bool
 {
+    if (options.failure_ratio <= 0.0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard { m_stats_lock };
+    return m_circuit_state == CircuitState::OPEN
+        && std::chrono::steady_clock::now() - m_circuit_opened_at < options.cool_down;
 }
 
-auto QueryPool::returnQuery(
-    std::unique_ptr<Query> query_handle_ptr) -> void
+auto QueryPool::recordCircuit(
+    bool succeeded,
+    bool admitted,
+    const CircuitBreakerOptions& options) -> void
 {
-    // If the handle has had any kind of error while processing
-    // simply release the memory and close it.
-    // libuv will shutdown the poll/timer handles
-    // and then delete the request handle.
-    if (query_handle_ptr->Error().has_value()) {
+    if (options.failure_ratio <= 0.0) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> guard { m_stats_lock };
+
+    // Only admitted probes decide a half open breaker.
+    if (!admitted && m_circuit_state != CircuitState::CLOSED) {
         return;
     }
 
+    auto open = [&]() {
+        m_circuit_state = CircuitState::OPEN;
+        m_circuit_opened_at = now;
+    };
+
+    switch (m_circuit_state) {
+        case CircuitState::CLOSED:
+            if (now - m_circuit_window_start >= options.window) {
+                m_circuit_window_start = now;
+                m_circuit_window_queries = 0;
+                m_circuit_window_failures = 0;
+            }
+
+            ++m_circuit_window_queries;
+            if (!succeeded) {
+                ++m_circuit_window_failures;
+            }
+
+            if (m_circuit_window_queries >= options.min_queries
+                && static_cast<double>(m_circuit_window_failures) >= options.failure_ratio * static_cast<double>(m_circuit_window_queries)) {
+                open();
+            }
+            break;
+        case CircuitState::HALF_OPEN:
+            if (!succeeded) {
+                open();
+            } else if (++m_circuit_probes_succeeded >= std::max<std::size_t>(options.half_open_queries, 1)) {
+                m_circuit_state = CircuitState::CLOSED;
+                m_circuit_window_start = now;
+                m_circuit_window_queries = 0;
+                m_circuit_window_failures = 0;
+            }
+            break;
+        case CircuitState::OPEN:
+            // Queries admitted before the breaker opened don't change it.
+            break;
+    }
+}
+
+auto QueryPool::limitAdmit(
+    QueryHandle& query_handle,
+    const ConcurrencyLimitOptions& options) -> LimitAdmit
+{
+    std::lock_guard<std::mutex> guard { m_stats_lock };
+    if (m_limit == 0.0) {
+        m_limit = static_cast<double>(std::clamp(options.initial_limit, std::max<std::size_t>(options.min_limit, 1), std::max(options.max_limit, options.initial_limit)));
+    }
+
+    // Parked queries go first, a new query can't take a slot they are waiting on.
+    if (m_limit_parked.empty() && static_cast<double>(m_limit_admitted) < std::floor(m_limit)) {
+        ++m_limit_admitted;
+        return LimitAdmit::ADMITTED;
+    }
+
+    if (options.max_wait <= std::chrono::milliseconds { 0 }) {
+        return LimitAdmit::SHED;
+    }
+
+    // At least one admitted query is executing, its recordLimit() resumes the parked queries.
+    m_limit_parked.emplace_back(std::chrono::steady_clock::now(), std::move(query_handle));
+    return LimitAdmit::PARKED;
+}
+
+auto QueryPool::recordLimit(
+    std::chrono::microseconds latency,
+    bool overloaded,
+    const ConcurrencyLimitOptions& options) -> std::vector<QueryHandle>
+{
+    // Sudden changes in query cost are absorbed by the average within a few hundred queries.
+    constexpr double average_weight = 0.01;
+
+    auto sample = static_cast<double>(latency.count());
+    auto min_limit = static_cast<double>(std::max<std::size_t>(options.min_limit, 1));
+    auto max_limit = std::max(static_cast<double>(options.max_limit), min_limit);
+
+    std::lock_guard<std::mutex> guard { m_stats_lock };
+    --m_limit_admitted;
+
+    if (m_limit_latency_average == 0.0) {
+        m_limit_latency_average = sample;
+    }
+
+    if (overloaded || sample > options.latency_tolerance * m_limit_latency_average) {
+        m_limit = std::max(m_limit * options.backoff_ratio, min_limit);
+    } else if (static_cast<double>(m_limit_admitted + 1) * 2.0 >= m_limit) {
+        // Only grow while the limit is in use, an idle server's limit says nothing about
+        // how much it can take.
+        m_limit = std::min(m_limit + 1.0 / m_limit, max_limit);
+    }
+
+    if (!overloaded) {
+        m_limit_latency_average += (sample - m_limit_latency_average) * average_weight;
+    }
+
+    return limitResume(options);
+}
+
+auto QueryPool::limitRelease(
+    const ConcurrencyLimitOptions& options) -> std::vector<QueryHandle>
+{
+    std::lock_guard<std::mutex> guard { m_stats_lock };
+    --m_limit_admitted;
+    return limitResume(options);
+}
+
+auto QueryPool::limitResume(
+    const ConcurrencyLimitOptions& options) -> std::vector<QueryHandle>
+{
+    std::vector<QueryHandle> resumed {};
+    limitShed(options, resumed);
+
+    while (!m_limit_parked.empty() && static_cast<double>(m_limit_admitted) < std::floor(m_limit)) {
+        auto& query_handle = m_limit_parked.front().second;
+        query_handle->m_limit_pool = this;
+        ++m_limit_admitted;
+        resumed.emplace_back(std::move(query_handle));
+        m_limit_parked.pop_front();
+    }
+
+    return resumed;
+}
+
+auto QueryPool::limitShed(
+    const ConcurrencyLimitOptions& options,
+    std::vector<QueryHandle>& shed) -> void
+{
+    auto now = std::chrono::steady_clock::now();
+    while (!m_limit_parked.empty() && now - m_limit_parked.front().first >= options.max_wait) {
+        auto& query_handle = m_limit_parked.front().second;
+        query_handle->setError(QueryStatus::OVERLOADED, "Concurrency limit reached, the server is overloaded");
+        shed.emplace_back(std::move(query_handle));
+        m_limit_parked.pop_front();
+    }
+}
+
+auto QueryPool::limitExpire(
+    const ConcurrencyLimitOptions& options,
+    std::chrono::steady_clock::time_point& next_deadline) -> std::vector<QueryHandle>
+{
+    std::vector<QueryHandle> shed {};
+
+    std::lock_guard<std::mutex> guard { m_stats_lock };
+    limitShed(options, shed);
+    if (!m_limit_parked.empty()) {
+        next_deadline = std::min(next_deadline, m_limit_parked.front().first + options.max_wait);
+    }
+
+    return shed;
+}
+
+auto QueryPool::limitDrain() -> std::vector<QueryHandle>
+{
+    std::vector<QueryHandle> shed {};
+
+    std::lock_guard<std::mutex> guard { m_stats_lock };
+    for (auto& [parked_at, query_handle] : m_limit_parked) {
+        (void)parked_at;
+        query_handle->setError(QueryStatus::OVERLOADED, "Concurrency limit reached, the executor stopped");
+        shed.emplace_back(std::move(query_handle));
+    }
+    m_limit_parked.clear();
+
+    return shed;
+}
+
+auto QueryPool::probe() -> std::optional<bool>
+{
+    auto connection = acquire();
+    if (connection == nullptr) {
+        return std::nullopt;
+    }
+
+    // A new connection proves the server accepts connections, an idle one is pinged.  A failed
+    // probe leaves the connection broken and the pool closes it.
+    bool alive = connection->m_is_connected ? connection->ping() : connection->connect();
+    release(std::move(connection));
+    return alive;
+}
+
+auto QueryPool::replicationLag(
+    std::optional<std::chrono::milliseconds> lag) -> void
+{
+    std::lock_guard<std::mutex> guard { m_stats_lock };
+    m_replication_lag = lag;
+    m_replication_lag_sampled_at = std::chrono::steady_clock::now();
+}
+
+auto QueryPool::staleness(
+    std::chrono::steady_clock::time_point now) -> std::optional<std::chrono::milliseconds>
+{
+    std::lock_guard<std::mutex> guard { m_stats_lock };
+    if (!m_replication_lag.has_value()) {
+        return std::nullopt;
+    }
+
+    return m_replication_lag.value() + std::chrono::duration_cast<std::chrono::milliseconds>(now - m_replication_lag_sampled_at);
+}
+
+auto QueryPool::connector() -> void
+{
+    mysql_thread_init();
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock { m_lock };
+            m_connector_cv.wait(lock, [this]() { return m_stop || m_connect_requests > 0; });
+            if (m_stop) {
+                break;
+            }
+            --m_connect_requests;
+            ++m_background_connecting;
+        }
+
+        // The requesting worker already counted this connection towards the total.
+        // Calling new instead of std::make_unique since the ctor is private
+        auto connection = std::unique_ptr<wing::Connection>(new wing::Connection(*this, m_connection));
+        bool connected = connection->connect();
+        if (connected) {
+            connection->m_idle_since = std::chrono::steady_clock::now();
+            connection->m_pinged_at = connection->m_idle_since;
+        } else {
+            // Throttled connections are never connected by the worker either.
+            connection->m_connect_failed = true;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard { m_lock };
+            --m_background_connecting;
+            if (connected) {
+                m_connections.emplace_back(std::move(connection));
+            } else if (m_acquirers_waiting > m_failed_connections.size()) {
+                m_failed_connections.emplace_back(std::move(connection));
+            }
+        }
+        // A failed connection nobody is waiting for is closed here, outside the lock.
+        connection.reset();
+        m_wait_cv.notify_all();
+    }
+
+    // Requests that were never started no longer count towards the total.
     {
-        query_handle_ptr->reset();
-        std::lock_guard<std::mutex> guard(m_lock);
-        m_queries.emplace_back(std::move(query_handle_ptr));
+        std::lock_guard<std::mutex> guard { m_lock };
+        m_total -= m_connect_requests;
+        m_connect_requests = 0;
     }
+
+    mysql_thread_end();
 }
 
-auto QueryPool::close() -> void
+auto QueryPool::keepalive() -> std::size_t
 {
-    std::lock_guard<std::mutex> guard(m_lock);
-    m_queries.clear();
+    if (m_options.keepalive_interval <= std::chrono::milliseconds { 0 }) {
+        return 0;
+    }
+
+    // Connections due for a ping are taken out of the pool so the lock isn't held during the
+    // round trips, they are the least recently returned connections at the front.
+    std::vector<std::unique_ptr<wing::Connection>> pinging {};
+    {
+        std::lock_guard<std::mutex> guard { m_lock };
+        auto now = std::chrono::steady_clock::now();
+        for (auto iter = m_connections.begin(); iter != m_connections.end();) {
+            auto& connection = *iter;
+            auto last_active = std::max(connection->m_idle_since, connection->m_pinged_at);
+            if (connection->m_is_connected && now - last_active >= m_options.keepalive_interval) {
+                pinging.emplace_back(std::move(connection));
+                iter = m_connections.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    }
+
+    std::size_t dead = 0;
+    for (auto& connection : pinging) {
+        if (!connection->ping()) {
+            connection.reset();
+            ++dead;
+        }
+    }
+
+    if (pinging.size() > dead) {
+        {
+            std::lock_guard<std::mutex> guard { m_lock };
+            for (auto iter = pinging.rbegin(); iter != pinging.rend(); ++iter) {
+                if (*iter != nullptr) {
+                    m_connections.emplace_front(std::move(*iter));
+                }
+            }
+        }
+        m_wait_cv.notify_all();
+    }
+
+    return dead;
 }
 
 } // wing
@@ -15,6 +15,8 @@ const std::string QUERY_STATUS_READ_FAILURE = "READ_FAILURE"s;
 const std::string QUERY_STATUS_STORE_FAILURE = "STORE_FAILURE"s;
 const std::string QUERY_STATUS_TIMEOUT = "TIMEOUT"s;
 const std::string QUERY_STATUS_DISCONNECT = "DISCONNECT"s;
+const std::string QUERY_STATUS_CIRCUIT_OPEN = "CIRCUIT_OPEN"s;
+const std::string QUERY_STATUS_OVERLOADED = "OVERLOADED"s;
 const std::string QUERY_STATUS_ERROR = "ERROR"s;
 
 auto to_string(
@@ -41,6 +43,10 @@ auto to_string(
         return QUERY_STATUS_TIMEOUT;
     case QueryStatus::DISCONNECT:
         return QUERY_STATUS_DISCONNECT;
+    case QueryStatus::CIRCUIT_OPEN:
+        return QUERY_STATUS_CIRCUIT_OPEN;
+    case QueryStatus::OVERLOADED:
+        return QUERY_STATUS_OVERLOADED;
     case QueryStatus::ERROR:
         return QUERY_STATUS_ERROR;
     default:
@@ -0,0 +1,221 @@
+#include "wing/ResultCache.hpp"
+#include "wing/Query.hpp"
+
+namespace wing {
+
+auto ResultCache::size() -> std::size_t
+{
+    std::lock_guard<std::mutex> guard { m_lock };
+    return m_entries.size();
+}
+
+auto ResultCache::bytes() -> std::size_t
+{
+    std::lock_guard<std::mutex> guard { m_lock };
+    return m_bytes;
+}
+
+auto ResultCache::clear() -> void
+{
+    std::lock_guard<std::mutex> guard { m_lock };
+    evictAll();
+}
+
+auto ResultCache::invalidate(
+    const std::string& tag) -> void
+{
+    auto normalized = Query::normalizeCacheTag(tag);
+    std::lock_guard<std::mutex> guard { m_lock };
+    invalidateTag(normalized);
+}
+
+ResultCache::ResultCache(
+    std::size_t max_bytes)
+    : m_max_bytes(max_bytes)
+{
+}
+
+auto ResultCache::find(
+    const std::string& key,
+    Query& query) -> bool
+{
+    std::lock_guard<std::mutex> guard { m_lock };
+
+    auto found = m_entries.find(key);
+    if (found == m_entries.end()) {
+        return false;
+    }
+
+    auto entry = found->second;
+    if (entry->m_expires_at <= std::chrono::steady_clock::now()) {
+        evict(entry);
+        return false;
+    }
+
+    m_lru.splice(m_lru.begin(), m_lru, entry);
+
+    query.m_query_status = QueryStatus::SUCCESS;
+    query.m_final_statement = entry->m_final_statement;
+    query.m_result_set = entry->m_result_set;
+    query.m_field_count = entry->m_result_set->FieldCount();
+    query.m_row_count = entry->m_result_set->RowCount();
+    query.m_from_cache = true;
+
+    return true;
+}
+
+auto ResultCache::beginRead() -> uint64_t
+{
+    std::lock_guard<std::mutex> guard { m_lock };
+    m_reading.emplace(m_epoch);
+    return m_epoch;
+}
+
+auto ResultCache::endRead(
+    uint64_t epoch) -> void
+{
+    std::lock_guard<std::mutex> guard { m_lock };
+    auto found = m_reading.find(epoch);
+    if (found != m_reading.end()) {
+        m_reading.erase(found);
+    }
+    pruneTags();
+}
+
+auto ResultCache::insert(
+    const Query& query) -> void
+{
+    if (query.m_result_set == nullptr) {
+        return;
+    }
+
+    const auto& key = query.m_statement_key;
+    auto tags = query.cacheTags();
+
+    auto bytes = sizeof(Entry) + key.length() + query.m_final_statement.length() + query.m_result_set->ByteSize();
+    for (const auto& tag : tags) {
+        bytes += tag.length();
+    }
+    if (bytes > m_max_bytes) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard { m_lock };
+
+    // A write invalidated this read's data while it was in flight, the result could be stale.
+    if (m_cleared_epoch > query.m_cache_epoch) {
+        return;
+    }
+    for (const auto& tag : tags) {
+        auto found = m_tags.find(tag);
+        if (found != m_tags.end() && found->second.m_invalidated_epoch > query.m_cache_epoch) {
+            return;
+        }
+    }
+
+    auto found = m_entries.find(key);
+    if (found != m_entries.end()) {
+        evict(found->second);
+    }
+
+    while (m_bytes + bytes > m_max_bytes && !m_lru.empty()) {
+        evict(std::prev(m_lru.end()));
+    }
+
+    m_lru.push_front(Entry {
+        key,
+        query.m_result_set,
+        query.m_final_statement,
+        std::chrono::steady_clock::now() + query.m_options.cache_ttl,
+        bytes,
+        std::move(tags) });
+
+    auto& entry = m_lru.front();
+    m_entries.emplace(entry.m_key, m_lru.begin());
+    for (const auto& tag : entry.m_tags) {
+        m_tags[tag].m_keys.emplace(entry.m_key);
+    }
+    m_bytes += bytes;
+}
+
+auto ResultCache::invalidate(
+    const Query& query) -> void
+{
+    invalidateTags(query.cacheTags());
+}
+
+auto ResultCache::invalidateTags(
+    const std::vector<std::string>& tags) -> void
+{
+    std::lock_guard<std::mutex> guard { m_lock };
+    if (tags.empty()) {
+        evictAll();
+    } else {
+        for (const auto& tag : tags) {
+            invalidateTag(tag);
+        }
+    }
+}
+
+auto ResultCache::invalidateTag(
+    const std::string& tag) -> void
+{
+    auto& tag_state = m_tags[tag];
+    tag_state.m_invalidated_epoch = ++m_epoch;
+
+    while (!tag_state.m_keys.empty()) {
+        evict(m_entries.at(*tag_state.m_keys.begin()));
+    }
+    idleTag(tag, tag_state);
+    pruneTags();
+}
+
+auto ResultCache::idleTag(
+    const std::string& tag,
+    const Tag& tag_state) -> void
+{
+    m_idle_tags.emplace(tag_state.m_invalidated_epoch, tag);
+}
+
+auto ResultCache::pruneTags() -> void
+{
+    // A read only checks tags invalidated after it started, a missing tag passes the check.
+    while (!m_idle_tags.empty()
+        && (m_reading.empty() || m_idle_tags.begin()->first <= *m_reading.begin())) {
+        auto idle = m_idle_tags.begin();
+        auto found = m_tags.find(idle->second);
+        if (found != m_tags.end()
+            && found->second.m_keys.empty()
+            && found->second.m_invalidated_epoch == idle->first) {
+            m_tags.erase(found);
+        }
+        m_idle_tags.erase(idle);
+    }
+}
+
+auto ResultCache::evictAll() -> void
+{
+    m_cleared_epoch = ++m_epoch;
+    m_entries.clear();
+    m_lru.clear();
+    m_tags.clear();
+    m_idle_tags.clear();
+    m_bytes = 0;
+}
+
+auto ResultCache::evict(
+    std::list<Entry>::iterator entry) -> void
+{
+    for (const auto& tag : entry->m_tags) {
+        auto& tag_state = m_tags[tag];
+        tag_state.m_keys.erase(entry->m_key);
+        if (tag_state.m_keys.empty()) {
+            idleTag(tag, tag_state);
+        }
+    }
+    m_bytes -= entry->m_bytes;
+    m_entries.erase(entry->m_key);
+    m_lru.erase(entry);
+}
+
+} // wing
@@ -0,0 +1,32 @@
+#include "wing/ResultSet.hpp"
+
+namespace wing {
+
+ResultSet::ResultSet(
+    MYSQL_RES* result)
+    : m_result(result)
+    , m_field_count(mysql_num_fields(result))
+{
+    m_rows.reserve(mysql_num_rows(m_result));
+    MYSQL_ROW mysql_row = nullptr;
+    while ((mysql_row = mysql_fetch_row(m_result))) {
+        auto lengths = mysql_fetch_lengths(m_result);
+        wing::Row row(mysql_row, m_field_count, lengths);
+        m_rows.emplace_back(std::move(row));
+
+        m_byte_size += sizeof(wing::Row) + m_field_count * sizeof(wing::Value);
+        for (size_t i = 0; i < m_field_count; ++i) {
+            m_byte_size += (lengths != nullptr) ? lengths[i] : 0;
+        }
+    }
+}
+
+ResultSet::~ResultSet()
+{
+    if (m_result != nullptr) {
+        mysql_free_result(m_result);
+        m_result = nullptr;
+    }
+}
+
+} // wing
@@ -1,8 +1,107 @@
 #include "wing/Statement.hpp"
 #include "wing/Util.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <unordered_set>
+
 namespace wing {
 
+/// Keywords that are followed by one or more table references.
+static const std::unordered_set<std::string> g_table_keywords {
+    "from", "join", "into", "update", "table", "truncate"
+};
+
+/// Keywords that can sit between a table keyword and the table reference.
+static const std::unordered_set<std::string> g_table_modifiers {
+    "low_priority", "delayed", "high_priority", "ignore", "quick", "temporary", "table", "if", "not",
+    "exists"
+};
+
+/// Keywords that end a clause of comma separated table references.
+static const std::unordered_set<std::string> g_table_terminators {
+    "where", "set", "values", "value", "select", "group", "order", "limit", "having", "union",
+    "for", "lock", "window", "into", "from", "partition"
+};
+
+/// Leading keywords of statements that never modify table data.
+static const std::unordered_set<std::string> g_non_modifying_keywords {
+    "SELECT", "SET", "USE", "SHOW", "EXPLAIN", "DESCRIBE", "DESC", "BEGIN", "START", "COMMIT",
+    "ROLLBACK", "SAVEPOINT", "RELEASE", "HELP"
+};
+
+/// Leading keywords of statements that leave state behind on the connection's session.
+static const std::unordered_set<std::string> g_session_keywords {
+    "SET", "USE", "LOCK", "UNLOCK", "BEGIN", "START", "SAVEPOINT", "PREPARE", "XA", "HANDLER"
+};
+
+static auto is_identifier_char(
+    char c) -> bool
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+static auto is_identifier(
+    const std::string& token) -> bool
+{
+    return !token.empty() && is_identifier_char(token.front()) && !std::isdigit(static_cast<unsigned char>(token.front()));
+}
+
+static auto to_lower(
+    std::string value) -> std::string
+{
+    for (auto& c : value) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return value;
+}
+
+/**
+ * Splits SQL text into lower cased identifiers and single character punctuation, string
+ * literals and comments are dropped.
+ */
+static auto tokenize(
+    const std::string& text) -> std::vector<std::string>
+{
+    std::vector<std::string> tokens {};
+
+    std::size_t i = 0;
+    while (i < text.length()) {
+        char c = text[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        } else if (c == '\'' || c == '"') {
+            ++i;
+            while (i < text.length() && text[i] != c) {
+                i += (text[i] == '\\') ? 2 : 1;
+            }
+            ++i;
+        } else if (c == '`') {
+            auto end = text.find('`', i + 1);
+            end = (end == std::string::npos) ? text.length() : end;
+            tokens.emplace_back(to_lower(text.substr(i + 1, end - i - 1)));
+            i = end + 1;
+        } else if (c == '#' || (c == '-' && i + 1 < text.length() && text[i + 1] == '-')) {
+            auto end = text.find('\n', i);
+            i = (end == std::string::npos) ? text.length() : end + 1;
+        } else if (c == '/' && i + 1 < text.length() && text[i + 1] == '*') {
+            auto end = text.find("*/", i + 2);
+            i = (end == std::string::npos) ? text.length() : end + 2;
+        } else if (is_identifier_char(c)) {
+            auto start = i;
+            while (i < text.length() && is_identifier_char(text[i])) {
+                ++i;
+            }
+            tokens.emplace_back(to_lower(text.substr(start, i - start)));
+        } else {
+            tokens.emplace_back(1, c);
+            ++i;
+        }
+    }
+
+    return tokens;
+}
+
 auto Statement::operator<<(
     Arg parameter) -> Statement&
 {
@@ -12,6 +111,216 @@ auto Statement::operator<<(
     return *this;
 }
 
+auto Statement::leadingKeyword() const -> std::string
+{
+    std::string keyword {};
+
+    if (m_statement_parts.empty() || m_statement_parts.front().m_requires_escaping) {
+        return keyword;
+    }
+
+    const auto& part = m_statement_parts.front().m_string_value;
+    std::size_t i = 0;
+    while (i < part.length() && std::isspace(static_cast<unsigned char>(part[i]))) {
+        ++i;
+    }
+    while (i < part.length() && std::isalpha(static_cast<unsigned char>(part[i]))) {
+        keyword.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(part[i]))));
+        ++i;
+    }
+
+    if (keyword != "WITH") {
+        return keyword;
+    }
+
+    // WITH [RECURSIVE] name [(columns)] AS (query) [, ...] statement
+    auto tokens = tokenize(rawText());
+    auto skip_parentheses = [&tokens](std::size_t idx) -> std::size_t {
+        if (idx >= tokens.size() || tokens[idx] != "(") {
+            return idx;
+        }
+        int64_t depth = 0;
+        for (; idx < tokens.size(); ++idx) {
+            if (tokens[idx] == "(") {
+                ++depth;
+            } else if (tokens[idx] == ")" && --depth == 0) {
+                return idx + 1;
+            }
+        }
+        return idx;
+    };
+
+    std::size_t idx = 1;
+    if (idx < tokens.size() && tokens[idx] == "recursive") {
+        ++idx;
+    }
+    while (idx < tokens.size()) {
+        idx = skip_parentheses(idx + 1);
+        if (idx < tokens.size() && tokens[idx] == "as") {
+            ++idx;
+        }
+        idx = skip_parentheses(idx);
+        if (idx < tokens.size() && tokens[idx] == ",") {
+            ++idx;
+            continue;
+        }
+        break;
+    }
+
+    if (idx < tokens.size() && is_identifier(tokens[idx])) {
+        keyword = tokens[idx];
+        std::transform(keyword.begin(), keyword.end(), keyword.begin(), [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    }
+
+    return keyword;
+}
+
+auto Statement::isDml() const -> bool
+{
+    auto keyword = leadingKeyword();
+    return keyword == "INSERT" || keyword == "UPDATE" || keyword == "DELETE" || keyword == "REPLACE";
+}
+
+auto Statement::isRead() const -> bool
+{
+    return leadingKeyword() == "SELECT";
+}
+
+auto Statement::isWrite() const -> bool
+{
+    return g_non_modifying_keywords.find(leadingKeyword()) == g_non_modifying_keywords.end();
+}
+
+auto Statement::changesSession() const -> bool
+{
+    if (g_session_keywords.find(leadingKeyword()) != g_session_keywords.end()) {
+        return true;
+    }
+
+    // Temporary tables, assigned user variables and named locks also outlive the statement.
+    auto tokens = tokenize(rawText());
+    auto token_at = [&tokens](std::size_t idx) -> const std::string& {
+        static const std::string g_end {};
+        return (idx < tokens.size()) ? tokens[idx] : g_end;
+    };
+
+    for (std::size_t i = 0; i < tokens.size(); ++i) {
+        const auto& token = tokens[i];
+        if (token == "temporary" || token == "get_lock") {
+            return true;
+        }
+
+        // @x := value or INTO @x, reading a user variable or an @@system_variable does not assign.
+        if (token == "@" && token_at(i - 1) != "@" && is_identifier(token_at(i + 1))
+            && ((token_at(i + 2) == ":" && token_at(i + 3) == "=") || token_at(i - 1) == "into")) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+auto Statement::isLockingRead() const -> bool
+{
+    auto tokens = tokenize(rawText());
+    for (std::size_t i = 0; i + 1 < tokens.size(); ++i) {
+        if ((tokens[i] == "for" && (tokens[i + 1] == "update" || tokens[i + 1] == "share"))
+            || (tokens[i] == "lock" && tokens[i + 1] == "in")) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+auto Statement::tables() const -> std::vector<std::string>
+{
+    auto tokens = tokenize(rawText());
+    auto token_at = [&tokens](std::size_t idx) -> const std::string& {
+        static const std::string g_end {};
+        return (idx < tokens.size()) ? tokens[idx] : g_end;
+    };
+
+    std::vector<std::string> tables {};
+
+    // Reads a single table reference starting at idx, returns the index after it.
+    auto read_table = [&](std::size_t idx) -> std::size_t {
+        while (g_table_modifiers.find(token_at(idx)) != g_table_modifiers.end()) {
+            ++idx;
+        }
+
+        if (is_identifier(token_at(idx))) {
+            // db.table resolves to just the table.
+            std::string table = token_at(idx++);
+            while (token_at(idx) == "." && is_identifier(token_at(idx + 1))) {
+                table = token_at(idx + 1);
+                idx += 2;
+            }
+            tables.emplace_back(std::move(table));
+        }
+
+        return idx;
+    };
+
+    for (std::size_t i = 0; i < tokens.size(); ++i) {
+        if (g_table_keywords.find(tokens[i]) == g_table_keywords.end()) {
+            continue;
+        }
+
+        auto j = read_table(i + 1);
+
+        // The rest of the clause can hold more comma separated table references, possibly after
+        // a join condition, scan until the clause ends at the same nesting depth.
+        int64_t depth = 0;
+        for (; j < tokens.size() && depth >= 0; ++j) {
+            const auto& token = tokens[j];
+            if (token == "(") {
+                ++depth;
+            } else if (token == ")") {
+                --depth;
+            } else if (depth == 0) {
+                if (token == ",") {
+                    j = read_table(j + 1) - 1;
+                } else if (g_table_terminators.find(token) != g_table_terminators.end()) {
+                    break;
+                }
+            }
+        }
+    }
+
+    std::sort(tables.begin(), tables.end());
+    tables.erase(std::unique(tables.begin(), tables.end()), tables.end());
+
+    return tables;
+}
+
+auto Statement::rawText() const -> std::string
+{
+    // Bound arguments are always values, never keywords or table references, so they are left out.
+    std::string text {};
+    for (const auto& part : m_statement_parts) {
+        text.append(part.m_requires_escaping ? "?" : part.m_string_value);
+    }
+    return text;
+}
+
+auto Statement::key() const -> std::string
+{
+    std::string key {};
+
+    for (const auto& part : m_statement_parts) {
+        if (part.m_requires_escaping) {
+            // Bound arguments are length prefixed so they can't be confused with raw parts.
+            key.push_back('\0');
+            key.append(std::to_string(part.m_string_value.length()));
+            key.push_back(':');
+        }
+        key.append(part.m_string_value);
+    }
+
+    return key;
+}
+
 Statement::StatementPart::StatementPart(
     std::string value,
     bool requires_escaping)
@@ -0,0 +1,272 @@
+#include "wing/Transaction.hpp"
+#include "wing/Executor.hpp"
+
+#include <mysql/mysqld_error.h>
+
+namespace wing {
+
+TransactionSession::TransactionSession(
+    Executor& executor,
+    std::chrono::milliseconds timeout,
+    std::size_t queue_index)
+    : m_executor(executor)
+    , m_timeout(timeout)
+    , m_queue_index(queue_index)
+{
+}
+
+auto TransactionSession::start(
+    Step step,
+    bool finish) -> bool
+{
+    std::unique_lock<std::mutex> guard { m_lock };
+    if (m_finishing || m_executor.m_stop) {
+        return false;
+    }
+
+    m_finishing = finish;
+    ++m_executor.m_queues[m_queue_index]->m_active_query_count;
+
+    if (!m_executing) {
+        m_executing = true;
+        auto connection = std::move(m_connection);
+        guard.unlock();
+        dispatch(std::move(connection), std::move(step));
+    } else {
+        m_pending.emplace_back(std::move(step));
+    }
+
+    return true;
+}
+
+auto TransactionSession::inspect(
+    const Query& query,
+    wing::Connection* connection) -> void
+{
+    std::lock_guard<std::mutex> guard { m_lock };
+
+    if (!m_broken_reason.has_value() && query.m_had_error) {
+        if (query.m_query_status == QueryStatus::CONNECT_FAILURE
+            || connection == nullptr
+            || connection->isBroken()) {
+            m_broken_reason = "Transaction connection was lost, the transaction was rolled back: " + query.m_error_message;
+        } else if (query.m_error_number == ER_LOCK_DEADLOCK) {
+            m_broken_reason = "Transaction was rolled back by the server: " + query.m_error_message;
+        }
+    }
+}
+
+auto TransactionSession::collectCacheTags(
+    const Query& query) -> std::optional<std::vector<std::string>>
+{
+    std::lock_guard<std::mutex> guard { m_lock };
+
+    if (query.isWrite()) {
+        // Invalidate even if the write failed, e.g. a lost connection can't tell if it applied.
+        auto tags = query.cacheTags();
+        if (tags.empty()) {
+            m_wrote_untagged = true;
+        }
+        m_cache_tags.insert(m_cache_tags.end(), tags.begin(), tags.end());
+        m_wrote = true;
+    }
+
+    // The finishing step is the last one, once it completes the transaction has ended.
+    if (!m_wrote || !m_finishing || !m_pending.empty()) {
+        return std::nullopt;
+    }
+
+    m_wrote = false;
+    if (m_wrote_untagged) {
+        m_cache_tags.clear();
+    }
+    return std::move(m_cache_tags);
+}
+
+auto TransactionSession::release(
+    std::unique_ptr<wing::Connection> connection) -> void
+{
+    std::unique_lock<std::mutex> guard { m_lock };
+
+    if (m_executor.m_stop) {
+        // The executor can no longer run statements, dropping the connection closes it which
+        // makes the server roll the transaction back.
+        m_executor.m_queues[m_queue_index]->m_active_query_count -= m_pending.size();
+        m_pending.clear();
+        m_finishing = true;
+        return;
+    }
+
+    if (!m_pending.empty()) {
+        auto step = std::move(m_pending.front());
+        m_pending.pop_front();
+        guard.unlock();
+        dispatch(std::move(connection), std::move(step));
+        return;
+    }
+
+    m_executing = false;
+    if (!m_finishing) {
+        m_connection = std::move(connection);
+        return;
+    }
+
+    auto broken = m_broken_reason.has_value();
+    guard.unlock();
+    if (connection == nullptr) {
+        return;
+    }
+
+    if (broken) {
+        // The server has already rolled the transaction back, the connection can only be
+        // re-used if it is reset to a clean session.  A lost connection is closed by the pool.
+        if (m_executor.m_query_pool.Options().reset_policy == ConnectionResetPolicy::NEVER) {
+            return;
+        }
+        connection->m_session_changed = true;
+    }
+    connection->setReconnect(connection->m_connection_info.Options().auto_reconnect);
+    connection->m_query_pool.release(std::move(connection));
+}
+
+auto TransactionSession::dispatch(
+    std::unique_ptr<wing::Connection> connection,
+    Step step) -> void
+{
+    auto query_handle = m_executor.m_query_pool.Produce(
+        std::move(step.m_statement),
+        step.m_timeout,
+        std::move(step.m_on_complete));
+    query_handle->m_session = shared_from_this();
+    query_handle->m_target_pool = &m_executor.primary();
+    query_handle->m_queue_index = m_queue_index;
+    query_handle->m_connection = std::move(connection);
+
+    {
+        std::lock_guard<std::mutex> guard { m_lock };
+        if (!m_broken_reason.has_value() && query_handle->m_connection == nullptr) {
+            m_broken_reason = "Transaction connection was lost, the transaction was rolled back";
+        }
+        if (m_broken_reason.has_value()) {
+            // The worker completes queries that already have an outcome without executing them.
+            query_handle->setError(QueryStatus::ERROR, m_broken_reason.value());
+        }
+    }
+
+    m_executor.enqueue(std::move(query_handle));
+}
+
+auto TransactionSession::markBroken(
+    std::string reason) -> void
+{
+    std::lock_guard<std::mutex> guard { m_lock };
+    if (!m_broken_reason.has_value()) {
+        m_broken_reason = std::move(reason);
+    }
+}
+
+Transaction::Transaction(
+    std::shared_ptr<TransactionSession> session)
+    : m_session(std::move(session))
+{
+}
+
+Transaction::~Transaction()
+{
+    if (m_session != nullptr) {
+        // Abandoned transactions are rolled back, this is a no-op if the transaction already finished.
+        wing::Statement rollback_stm {};
+        rollback_stm << "ROLLBACK";
+        (void)start(std::move(rollback_stm), m_session->m_timeout, [](QueryHandle) {}, true);
+    }
+}
+
+auto Transaction::StartQuery(
+    wing::Statement statement,
+    std::chrono::milliseconds timeout,
+    std::function<void(QueryHandle)> on_complete) -> bool
+{
+    return start(std::move(statement), timeout, std::move(on_complete), false);
+}
+
+auto Transaction::StartQuery(
+    wing::Statement statement,
+    std::chrono::milliseconds timeout) -> std::optional<std::future<QueryHandle>>
+{
+    return startFuture(std::move(statement), timeout, false);
+}
+
+auto Transaction::Commit(
+    std::chrono::milliseconds timeout,
+    std::function<void(QueryHandle)> on_complete) -> bool
+{
+    wing::Statement commit_stm {};
+    commit_stm << "COMMIT";
+    return start(std::move(commit_stm), timeout, std::move(on_complete), true);
+}
+
+auto Transaction::Commit(
+    std::chrono::milliseconds timeout) -> std::optional<std::future<QueryHandle>>
+{
+    wing::Statement commit_stm {};
+    commit_stm << "COMMIT";
+    return startFuture(std::move(commit_stm), timeout, true);
+}
+
+auto Transaction::Rollback(
+    std::chrono::milliseconds timeout,
+    std::function<void(QueryHandle)> on_complete) -> bool
+{
+    wing::Statement rollback_stm {};
+    rollback_stm << "ROLLBACK";
+    return start(std::move(rollback_stm), timeout, std::move(on_complete), true);
+}
+
+auto Transaction::Rollback(
+    std::chrono::milliseconds timeout) -> std::optional<std::future<QueryHandle>>
+{
+    wing::Statement rollback_stm {};
+    rollback_stm << "ROLLBACK";
+    return startFuture(std::move(rollback_stm), timeout, true);
+}
+
+auto Transaction::start(
+    wing::Statement statement,
+    std::chrono::milliseconds timeout,
+    std::function<void(QueryHandle)> on_complete,
+    bool finish) -> bool
+{
+    if (m_session == nullptr) {
+        return false;
+    }
+
+    return m_session->start(
+        TransactionSession::Step { std::move(statement), timeout, std::move(on_complete) },
+        finish);
+}
+
+auto Transaction::startFuture(
+    wing::Statement statement,
+    std::chrono::milliseconds timeout,
+    bool finish) -> std::optional<std::future<QueryHandle>>
+{
+    std::optional<std::future<QueryHandle>> result {};
+
+    // std::function is broken and requires everything to be copyable :(
+    auto query_promise_ptr = std::make_shared<std::promise<QueryHandle>>();
+    auto query_future = query_promise_ptr->get_future();
+
+    if (start(
+            std::move(statement),
+            timeout,
+            [p = std::move(query_promise_ptr)](QueryHandle query_handle) mutable {
+                p->set_value(std::move(query_handle));
+            },
+            finish)) {
+        result.emplace(std::move(query_future));
+    }
+
+    return result;
+}
+
+} // wing
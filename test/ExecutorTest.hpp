@@ -0,0 +1,928 @@
+#pragma once
+
+#include "catch.hpp"
+
+#include <wing/WingMySQL.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <optional>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Group commit coalesces queued writes")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo connection { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::Executor executor { std::move(connection) };
+
+    wing::QueryOptions options {};
+    options.group_commit = true;
+
+    std::vector<std::future<wing::QueryHandle>> futures {};
+    for (std::size_t i = 0; i < 10; ++i) {
+        wing::Statement insert_stm {};
+        insert_stm << "INSERT INTO " << MYSQL_DATABASE << ".integers (i) VALUES (" << i << ")";
+        futures.emplace_back(executor.StartQuery(std::move(insert_stm), 10s, options).value());
+    }
+
+    for (auto& future : futures) {
+        auto insert_query = future.get();
+        query_print_error(insert_query);
+        REQUIRE(insert_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+        REQUIRE(insert_query->RowCount() == 1);
+        REQUIRE(insert_query->LastInsertId() > 0);
+    }
+}
+
+TEST_CASE("Group commit falls back to individual writes on failure")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo connection { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::Executor executor { std::move(connection) };
+
+    wing::QueryOptions options {};
+    options.group_commit = true;
+
+    wing::Statement good_stm {};
+    good_stm << "INSERT INTO " << MYSQL_DATABASE << ".string (vc) VALUES ('GOOD')";
+    wing::Statement bad_stm {};
+    bad_stm << "INSERT INTO " << MYSQL_DATABASE << ".does_not_exist (vc) VALUES ('BAD')";
+
+    auto good_future = executor.StartQuery(good_stm, 10s, options).value();
+    auto bad_future = executor.StartQuery(bad_stm, 10s, options).value();
+    auto good_future2 = executor.StartQuery(good_stm, 10s, options).value();
+
+    auto good_query = good_future.get();
+    query_print_error(good_query);
+    REQUIRE(good_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+
+    auto bad_query = bad_future.get();
+    REQUIRE(bad_query->QueryStatus() == wing::QueryStatus::ERROR);
+    REQUIRE(bad_query->Error().has_value());
+
+    auto good_query2 = good_future2.get();
+    query_print_error(good_query2);
+    REQUIRE(good_query2->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(good_query->LastInsertId() != good_query2->LastInsertId());
+}
+
+TEST_CASE("Single flight reads share one result")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo connection { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::Executor executor { std::move(connection) };
+
+    wing::QueryOptions options {};
+    options.single_flight = true;
+
+    wing::Statement select_stm {};
+    select_stm << "SELECT SLEEP(0.5), 'shared'";
+
+    std::vector<std::future<wing::QueryHandle>> futures {};
+    for (std::size_t i = 0; i < 5; ++i) {
+        futures.emplace_back(executor.StartQuery(select_stm, 10s, options).value());
+    }
+
+    std::vector<wing::QueryHandle> queries {};
+    for (auto& future : futures) {
+        queries.emplace_back(future.get());
+    }
+
+    for (auto& select_query : queries) {
+        query_print_error(select_query);
+        REQUIRE(select_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+        REQUIRE(select_query->RowCount() == 1);
+        // Every query shares the first query's rows rather than a copy of them.
+        REQUIRE(&select_query->Rows() == &queries.front()->Rows());
+    }
+
+    // Followers of a failed read share its error, including the server's error number.
+    wing::Statement sleep_stm {};
+    sleep_stm << "SELECT SLEEP(0.2)";
+    auto sleep_future = executor.StartQuery(std::move(sleep_stm), 10s).value();
+
+    wing::Statement bad_stm {};
+    bad_stm << "SELECT * FROM " << MYSQL_DATABASE << ".table_that_does_not_exist";
+    std::vector<std::future<wing::QueryHandle>> bad_futures {};
+    for (std::size_t i = 0; i < 3; ++i) {
+        bad_futures.emplace_back(executor.StartQuery(bad_stm, 10s, options).value());
+    }
+
+    REQUIRE(sleep_future.get()->QueryStatus() == wing::QueryStatus::SUCCESS);
+    for (auto& future : bad_futures) {
+        auto bad_query = future.get();
+        REQUIRE(bad_query->QueryStatus() == wing::QueryStatus::ERROR);
+        REQUIRE(bad_query->Error().has_value());
+        REQUIRE(bad_query->ErrorNumber() == ER_NO_SUCH_TABLE);
+    }
+}
+
+TEST_CASE("Result cache serves repeated reads")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo connection { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::ExecutorOptions executor_options {};
+    executor_options.result_cache_max_bytes = 1024 * 1024;
+    wing::Executor executor { std::move(connection), 1, executor_options };
+    REQUIRE(executor.Cache() != nullptr);
+
+    wing::QueryOptions options {};
+    options.cache_ttl = 10s;
+
+    wing::Statement select_stm {};
+    select_stm << "SELECT 'cached'";
+
+    auto first_query = executor.StartQuery(select_stm, 10s, options).value().get();
+    query_print_error(first_query);
+    REQUIRE(first_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE_FALSE(first_query->FromCache());
+    REQUIRE(executor.Cache()->size() == 1);
+
+    auto second_query = executor.StartQuery(select_stm, 10s, options).value().get();
+    REQUIRE(second_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(second_query->FromCache());
+    REQUIRE(second_query->RowCount() == 1);
+    REQUIRE(second_query->Row(0).Column(0).AsStringView() == "cached");
+
+    executor.Cache()->clear();
+    REQUIRE(executor.Cache()->size() == 0);
+    REQUIRE(executor.Cache()->bytes() == 0);
+}
+
+TEST_CASE("Result cache is invalidated by writes to the tables it read")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo connection { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::ExecutorOptions executor_options {};
+    executor_options.result_cache_max_bytes = 1024 * 1024;
+    wing::Executor executor { std::move(connection), 1, executor_options };
+
+    wing::QueryOptions options {};
+    options.cache_ttl = 60s;
+
+    wing::Statement count_stm {};
+    count_stm << "SELECT COUNT(*) FROM " << MYSQL_DATABASE << ".string";
+
+    auto first_count = executor.StartQuery(count_stm, 10s, options).value().get();
+    query_print_error(first_count);
+    REQUIRE(first_count->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(executor.Cache()->size() == 1);
+
+    wing::Statement insert_stm {};
+    insert_stm << "INSERT INTO " << MYSQL_DATABASE << ".string (vc) VALUES ('TAG')";
+    auto insert_query = executor.StartQuery(std::move(insert_stm), 10s).value().get();
+    query_print_error(insert_query);
+    REQUIRE(insert_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(executor.Cache()->size() == 0);
+
+    auto second_count = executor.StartQuery(count_stm, 10s, options).value().get();
+    REQUIRE(second_count->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE_FALSE(second_count->FromCache());
+    REQUIRE(second_count->Row(0).Column(0).AsUInt64().value() == first_count->Row(0).Column(0).AsUInt64().value() + 1);
+
+    // Tags are matched case insensitively and without the database qualifier.
+    REQUIRE(executor.StartQuery(count_stm, 10s, options).value().get()->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(executor.Cache()->size() == 1);
+    executor.Cache()->invalidate(MYSQL_DATABASE + ".STRING");
+    REQUIRE(executor.Cache()->size() == 0);
+
+    // A transaction's writes invalidate once it commits, until then other sessions read the old rows.
+    REQUIRE(executor.StartQuery(count_stm, 10s, options).value().get()->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(executor.Cache()->size() == 1);
+    auto transaction = executor.StartTransaction(10s).value();
+    wing::Statement tx_insert_stm {};
+    tx_insert_stm << "INSERT INTO " << MYSQL_DATABASE << ".string (vc) VALUES ('TAG')";
+    auto tx_insert_query = transaction.StartQuery(std::move(tx_insert_stm), 10s).value().get();
+    query_print_error(tx_insert_query);
+    REQUIRE(tx_insert_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(executor.Cache()->size() == 1);
+    auto commit_query = transaction.Commit(10s).value().get();
+    query_print_error(commit_query);
+    REQUIRE(commit_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(executor.Cache()->size() == 0);
+}
+
+TEST_CASE("Transaction pins a single connection")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo connection { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::Executor executor { std::move(connection), 2 };
+
+    auto transaction = executor.StartTransaction(10s).value();
+
+    wing::Statement connection_id_stm {};
+    connection_id_stm << "SELECT CONNECTION_ID()";
+
+    wing::Statement insert_stm {};
+    insert_stm << "INSERT INTO " << MYSQL_DATABASE << ".string (vc) VALUES ('TX')";
+
+    // Statements are pipelined, each one starts once the previous statement has completed.
+    auto first_id_future = transaction.StartQuery(connection_id_stm, 10s).value();
+    auto insert_future = transaction.StartQuery(insert_stm, 10s).value();
+    auto second_id_future = transaction.StartQuery(connection_id_stm, 10s).value();
+    auto rollback_future = transaction.Rollback(10s).value();
+    REQUIRE_FALSE(transaction.StartQuery(connection_id_stm, 10s).has_value());
+
+    uint64_t first_id = 0;
+    {
+        auto first_id_query = first_id_future.get();
+        query_print_error(first_id_query);
+        REQUIRE(first_id_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+        first_id = first_id_query->Row(0).Column(0).AsUInt64().value();
+    }
+
+    uint64_t insert_id = 0;
+    {
+        auto insert_query = insert_future.get();
+        query_print_error(insert_query);
+        REQUIRE(insert_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+        insert_id = insert_query->LastInsertId();
+    }
+
+    {
+        auto second_id_query = second_id_future.get();
+        REQUIRE(second_id_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+        REQUIRE(second_id_query->Row(0).Column(0).AsUInt64().value() == first_id);
+    }
+
+    {
+        auto rollback_query = rollback_future.get();
+        query_print_error(rollback_query);
+        REQUIRE(rollback_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    }
+
+    wing::Statement select_stm {};
+    select_stm << "SELECT vc FROM " << MYSQL_DATABASE << ".string WHERE id = " << insert_id;
+    auto select_query = executor.StartQuery(std::move(select_stm), 10s).value().get();
+    REQUIRE(select_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(select_query->RowCount() == 0);
+}
+
+TEST_CASE("Query pool bounds its connections")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo connection { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::ExecutorOptions executor_options {};
+    executor_options.query_pool.max_connections = 1;
+    wing::Executor executor { std::move(connection), 2, executor_options };
+
+    wing::Statement select_stm {};
+    select_stm << "SELECT 1";
+
+    {
+        // Holding a result does not hold the connection it was read from.
+        auto held_query = executor.StartQuery(select_stm, 10s).value().get();
+        REQUIRE(held_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+
+        auto select_query = executor.StartQuery(select_stm, 10s).value().get();
+        REQUIRE(select_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    }
+
+    {
+        // A transaction pins the only connection, with no max wait other queries fail.
+        auto transaction = executor.StartTransaction(10s).value();
+        auto tx_query = transaction.StartQuery(select_stm, 10s).value().get();
+        REQUIRE(tx_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+
+        auto select_query = executor.StartQuery(select_stm, 10s).value().get();
+        REQUIRE(select_query->QueryStatus() == wing::QueryStatus::CONNECT_FAILURE);
+
+        auto rollback_query = transaction.Rollback(10s).value().get();
+        REQUIRE(rollback_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    }
+
+    auto select_query = executor.StartQuery(select_stm, 10s).value().get();
+    REQUIRE(select_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+}
+
+TEST_CASE("SQL errors keep the connection pooled")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo connection { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::Executor executor { std::move(connection) };
+
+    wing::Statement connection_id_stm {};
+    connection_id_stm << "SELECT CONNECTION_ID()";
+
+    uint64_t first_id = 0;
+    {
+        auto first_id_query = executor.StartQuery(connection_id_stm, 10s).value().get();
+        REQUIRE(first_id_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+        first_id = first_id_query->Row(0).Column(0).AsUInt64().value();
+    }
+
+    {
+        wing::Statement bad_stm {};
+        bad_stm << "SELECT * FROM " << MYSQL_DATABASE << ".table_that_does_not_exist";
+        auto bad_query = executor.StartQuery(std::move(bad_stm), 10s).value().get();
+        REQUIRE(bad_query->QueryStatus() == wing::QueryStatus::ERROR);
+        REQUIRE(bad_query->ErrorNumber() > 0);
+    }
+
+    auto second_id_query = executor.StartQuery(connection_id_stm, 10s).value().get();
+    REQUIRE(second_id_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(second_id_query->Row(0).Column(0).AsUInt64().value() == first_id);
+}
+
+TEST_CASE("Session changes are reset when the connection is returned")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo connection { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::Executor executor { std::move(connection) };
+
+    uint64_t first_id = 0;
+    {
+        wing::Statement set_stm {};
+        set_stm << "SET @wing_reset_test = 1";
+        auto set_query = executor.StartQuery(std::move(set_stm), 10s).value().get();
+        query_print_error(set_query);
+        REQUIRE(set_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    }
+
+    {
+        wing::Statement connection_id_stm {};
+        connection_id_stm << "SELECT CONNECTION_ID()";
+        auto id_query = executor.StartQuery(std::move(connection_id_stm), 10s).value().get();
+        first_id = id_query->Row(0).Column(0).AsUInt64().value();
+    }
+
+    wing::Statement select_stm {};
+    select_stm << "SELECT @wing_reset_test, CONNECTION_ID()";
+    auto select_query = executor.StartQuery(std::move(select_stm), 10s).value().get();
+    REQUIRE(select_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(select_query->Row(0).Column(0).IsNull());
+    // The connection was reset, not reconnected.
+    REQUIRE(select_query->Row(0).Column(1).AsUInt64().value() == first_id);
+}
+
+TEST_CASE("Keepalive replaces dead idle connections")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo connection { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::ExecutorOptions executor_options {};
+    executor_options.query_pool.keepalive_interval = 50ms;
+    executor_options.query_pool.maintenance_interval = 10ms;
+    wing::Executor executor { connection, 1, executor_options };
+    wing::Executor killer { connection };
+
+    wing::Statement connection_id_stm {};
+    connection_id_stm << "SELECT CONNECTION_ID()";
+
+    uint64_t first_id = 0;
+    {
+        auto id_query = executor.StartQuery(connection_id_stm, 10s).value().get();
+        REQUIRE(id_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+        first_id = id_query->Row(0).Column(0).AsUInt64().value();
+    }
+
+    {
+        wing::Statement kill_stm {};
+        kill_stm << "KILL " << first_id;
+        auto kill_query = killer.StartQuery(std::move(kill_stm), 10s).value().get();
+        query_print_error(kill_query);
+        REQUIRE(kill_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    }
+
+    // Give the keepalive time to find the dead connection and replace it.
+    std::this_thread::sleep_for(250ms);
+
+    auto id_query = executor.StartQuery(connection_id_stm, 10s).value().get();
+    query_print_error(id_query);
+    REQUIRE(id_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(id_query->Row(0).Column(0).AsUInt64().value() != first_id);
+}
+
+TEST_CASE("Workers keep their cached connections across short idles")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo connection { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::ExecutorOptions executor_options {};
+    executor_options.query_pool.idle_timeout = 500ms;
+    executor_options.query_pool.maintenance_interval = 10ms;
+    wing::Executor executor { std::move(connection), 1, executor_options };
+    const auto& worker = executor.Workers().front();
+
+    wing::Statement connection_id_stm {};
+    connection_id_stm << "SELECT CONNECTION_ID()";
+
+    auto first_query = executor.StartQuery(connection_id_stm, 10s).value().get();
+    query_print_error(first_query);
+    REQUIRE(first_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    auto first_id = first_query->Row(0).Column(0).AsUInt64().value();
+
+    // The worker holds on to its connection while idle and re-uses it without the pool.
+    std::this_thread::sleep_for(50ms);
+    REQUIRE(worker.CachedConnectionCount() == 1);
+    auto second_query = executor.StartQuery(connection_id_stm, 10s).value().get();
+    REQUIRE(second_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(second_query->Row(0).Column(0).AsUInt64().value() == first_id);
+    REQUIRE(worker.CachedConnectionCount() == 1);
+
+    // Once idle past the idle timeout the connection is handed back to the pool.
+    std::this_thread::sleep_for(1500ms);
+    REQUIRE(worker.CachedConnectionCount() == 0);
+}
+
+TEST_CASE("Shared nothing workers own their connections")
+{
+    using namespace std::chrono_literals;
+    constexpr std::size_t num_workers = 4;
+    constexpr std::size_t num_shards = 8;
+    constexpr std::size_t queries_per_shard = 10;
+
+    wing::ConnectionInfo connection { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::ExecutorOptions executor_options {};
+    executor_options.shared_nothing = true;
+    wing::Executor executor { std::move(connection), num_workers, executor_options };
+
+    wing::Statement connection_id_stm {};
+    connection_id_stm << "SELECT CONNECTION_ID(), SLEEP(0.005)";
+
+    // Start every shard's queries at once, with shared queues the idle workers would pick up
+    // the queries of any shard on any of their connections.
+    auto worker_of = [](const std::string& shard_key) {
+        return std::hash<std::string> {}(shard_key) % num_workers;
+    };
+    std::vector<std::pair<std::string, std::future<wing::QueryHandle>>> futures {};
+    std::vector<uint64_t> expected_counts(num_workers, 0);
+    for (std::size_t i = 0; i < queries_per_shard; ++i) {
+        for (std::size_t shard = 0; shard < num_shards; ++shard) {
+            wing::QueryOptions options {};
+            options.shard_key = "shard-" + std::to_string(shard);
+            futures.emplace_back(options.shard_key, executor.StartQuery(connection_id_stm, 10s, options).value());
+            ++expected_counts[worker_of(options.shard_key)];
+        }
+    }
+
+    // Every query of a shard runs on the same worker, which keeps re-using its own connection.
+    std::vector<std::optional<uint64_t>> worker_ids(num_workers);
+    for (auto& [shard_key, future] : futures) {
+        auto id_query = future.get();
+        query_print_error(id_query);
+        REQUIRE(id_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+        auto id = id_query->Row(0).Column(0).AsUInt64().value();
+        auto& worker_id = worker_ids[worker_of(shard_key)];
+        if (!worker_id.has_value()) {
+            worker_id = id;
+        }
+        REQUIRE(id == worker_id.value());
+    }
+
+    // Workers never share connections.
+    for (std::size_t i = 0; i < num_workers; ++i) {
+        for (std::size_t j = i + 1; j < num_workers; ++j) {
+            if (worker_ids[i].has_value() && worker_ids[j].has_value()) {
+                REQUIRE(worker_ids[i].value() != worker_ids[j].value());
+            }
+        }
+    }
+
+    // A worker only executes the queries of its own shards, it counts them once the callback returns.
+    std::this_thread::sleep_for(100ms);
+    for (std::size_t i = 0; i < num_workers; ++i) {
+        REQUIRE(executor.Workers()[i].CompletedQueryCount() == expected_counts[i]);
+    }
+}
+
+TEST_CASE("Connect failures back off")
+{
+    using namespace std::chrono_literals;
+    // Nothing listens on port 1, connecting fails right away.
+    wing::ConnectionInfo connection { "127.0.0.1", 1, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::ExecutorOptions executor_options {};
+    executor_options.query_pool.connect_backoff_initial = 10s;
+    wing::Executor executor { std::move(connection), 1, executor_options };
+
+    wing::Statement select_stm {};
+    select_stm << "SELECT 1";
+
+    auto first_query = executor.StartQuery(select_stm, 10s).value().get();
+    REQUIRE(first_query->QueryStatus() == wing::QueryStatus::CONNECT_FAILURE);
+    REQUIRE(first_query->ErrorNumber() > 0);
+
+    // The server isn't contacted again during the backoff.
+    auto second_query = executor.StartQuery(select_stm, 10s).value().get();
+    REQUIRE(second_query->QueryStatus() == wing::QueryStatus::CONNECT_FAILURE);
+    REQUIRE(second_query->ErrorNumber() == 0);
+}
+
+TEST_CASE("Background connectors connect for the workers")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo connection { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::ExecutorOptions executor_options {};
+    executor_options.query_pool.background_connectors = 1;
+    executor_options.query_pool.max_connections = 2;
+    executor_options.query_pool.max_wait = 10s;
+    wing::Executor executor { std::move(connection), 4, executor_options };
+
+    wing::Statement select_stm {};
+    select_stm << "SELECT 1";
+
+    std::vector<std::future<wing::QueryHandle>> futures {};
+    for (std::size_t i = 0; i < 8; ++i) {
+        futures.emplace_back(executor.StartQuery(select_stm, 10s).value());
+    }
+
+    for (auto& future : futures) {
+        auto query = future.get();
+        query_print_error(query);
+        REQUIRE(query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    }
+
+    // Nothing listens on port 1, the connector's failure is reported by the waiting query.
+    wing::ConnectionInfo unreachable { "127.0.0.1", 1, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::ExecutorOptions unreachable_options {};
+    unreachable_options.query_pool.background_connectors = 1;
+    wing::Executor unreachable_executor { std::move(unreachable), 1, unreachable_options };
+
+    auto failed_query = unreachable_executor.StartQuery(select_stm, 10s).value().get();
+    REQUIRE(failed_query->QueryStatus() == wing::QueryStatus::CONNECT_FAILURE);
+    REQUIRE(failed_query->ErrorNumber() > 0);
+}
+
+TEST_CASE("Connection options are applied to new connections")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionOptions connection_options {};
+    connection_options.compression = wing::CompressionAlgorithm::ZLIB;
+    connection_options.charset = "utf8mb4";
+    connection_options.write_timeout = 5s;
+    wing::ConnectionInfo connection { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD, "", 0, connection_options };
+    wing::Executor executor { std::move(connection), 1 };
+
+    wing::Statement compression_stm {};
+    compression_stm << "SHOW SESSION STATUS LIKE 'Compression'";
+    auto compression_query = executor.StartQuery(std::move(compression_stm), 10s).value().get();
+    query_print_error(compression_query);
+    REQUIRE(compression_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(compression_query->Row(0).Column(1).AsStringView().value() == "ON");
+
+    wing::Statement charset_stm {};
+    charset_stm << "SELECT @@character_set_client";
+    auto charset_query = executor.StartQuery(std::move(charset_stm), 10s).value().get();
+    query_print_error(charset_query);
+    REQUIRE(charset_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(charset_query->Row(0).Column(0).AsStringView().value() == "utf8mb4");
+}
+
+TEST_CASE("Reads are routed to replicas and writes to the primary")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo primary { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    // Nothing listens on port 1, so every query routed to the replica fails to connect.
+    std::vector<wing::ConnectionInfo> replicas {};
+    replicas.emplace_back("127.0.0.1", 1, MYSQL_USERNAME, MYSQL_PASSWORD);
+    wing::Executor executor { std::move(primary), std::move(replicas), 1 };
+
+    auto start = [&executor](std::string sql, wing::QueryOptions options = wing::QueryOptions {}) {
+        wing::Statement stm {};
+        stm << std::move(sql);
+        return executor.StartQuery(std::move(stm), 10s, std::move(options)).value().get();
+    };
+
+    REQUIRE(start("SELECT 1")->QueryStatus() == wing::QueryStatus::CONNECT_FAILURE);
+    REQUIRE(start("SELECT 1 FOR UPDATE")->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(start("SET @wing_route = 1")->QueryStatus() == wing::QueryStatus::SUCCESS);
+
+    wing::QueryOptions primary_options {};
+    primary_options.route = wing::QueryRoute::PRIMARY;
+    REQUIRE(start("SELECT 1", primary_options)->QueryStatus() == wing::QueryStatus::SUCCESS);
+}
+
+TEST_CASE("Latency aware balancing steers reads away from a failing replica")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo primary { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    std::vector<wing::ConnectionInfo> replicas {};
+    replicas.emplace_back(MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD);
+    // Nothing listens on port 1, its failures are penalized with the query timeout.
+    replicas.emplace_back("127.0.0.1", 1, MYSQL_USERNAME, MYSQL_PASSWORD);
+    wing::Executor executor { std::move(primary), std::move(replicas), 1 };
+
+    wing::Statement select_stm {};
+    select_stm << "SELECT 1";
+
+    std::size_t failures = 0;
+    for (std::size_t i = 0; i < 20; ++i) {
+        auto query = executor.StartQuery(select_stm, 10s).value().get();
+        if (query->QueryStatus() != wing::QueryStatus::SUCCESS) {
+            ++failures;
+        }
+    }
+
+    // The failing replica is only tried until its first failure.
+    REQUIRE(failures <= 1);
+}
+
+TEST_CASE("Reads with a max staleness skip lagging replicas")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo primary { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    // Nothing listens on port 1, the replica's lag is never known.
+    std::vector<wing::ConnectionInfo> replicas {};
+    replicas.emplace_back("127.0.0.1", 1, MYSQL_USERNAME, MYSQL_PASSWORD);
+    wing::ExecutorOptions executor_options {};
+    executor_options.replica_lag_interval = 50ms;
+    wing::Executor executor { std::move(primary), std::move(replicas), 1, executor_options };
+
+    wing::Statement select_stm {};
+    select_stm << "SELECT 1";
+
+    wing::QueryOptions bounded_options {};
+    bounded_options.max_staleness = 1s;
+    auto bounded_query = executor.StartQuery(select_stm, 10s, bounded_options).value().get();
+    query_print_error(bounded_query);
+    REQUIRE(bounded_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+
+    auto unbounded_query = executor.StartQuery(select_stm, 10s).value().get();
+    REQUIRE(unbounded_query->QueryStatus() == wing::QueryStatus::CONNECT_FAILURE);
+}
+
+TEST_CASE("Writes return a consistency token for reading them back")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo primary { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    // The primary doubles as its own replica, it has always applied its own writes.
+    std::vector<wing::ConnectionInfo> replicas {};
+    replicas.emplace_back(MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD);
+    wing::ExecutorOptions executor_options {};
+    executor_options.track_gtids = true;
+    wing::Executor executor { std::move(primary), std::move(replicas), 1, executor_options };
+
+    wing::Statement gtid_mode_stm {};
+    gtid_mode_stm << "SELECT @@GLOBAL.gtid_mode";
+    auto gtid_mode_query = executor.StartQuery(std::move(gtid_mode_stm), 10s).value().get();
+    query_print_error(gtid_mode_query);
+    REQUIRE(gtid_mode_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    bool gtids_enabled = (gtid_mode_query->Row(0).Column(0).AsStringView().value() == "ON");
+
+    wing::Statement insert_stm {};
+    insert_stm << "INSERT INTO " << MYSQL_DATABASE << ".integers (i) VALUES (44)";
+    auto insert_query = executor.StartQuery(std::move(insert_stm), 10s).value().get();
+    query_print_error(insert_query);
+    REQUIRE(insert_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(insert_query->ConsistencyToken().empty() == !gtids_enabled);
+
+    wing::QueryOptions read_options {};
+    read_options.consistency_token = insert_query->ConsistencyToken();
+    wing::Statement select_stm {};
+    select_stm << "SELECT i FROM " << MYSQL_DATABASE << ".integers WHERE i = 44";
+    auto select_query = executor.StartQuery(std::move(select_stm), 10s, read_options).value().get();
+    query_print_error(select_query);
+    REQUIRE(select_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(select_query->RowCount() > 0);
+}
+
+TEST_CASE("Writes fail over to a standby when the primary is unhealthy")
+{
+    using namespace std::chrono_literals;
+    // Nothing listens on port 1, the primary is down.
+    wing::ConnectionInfo primary { "127.0.0.1", 1, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::ExecutorOptions executor_options {};
+    executor_options.standby.emplace(MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD);
+    executor_options.unhealthy_threshold = 1;
+    executor_options.health_check_interval = 0ms;
+    wing::Executor executor { std::move(primary), 1, executor_options };
+
+    wing::Statement insert_stm {};
+    insert_stm << "INSERT INTO " << MYSQL_DATABASE << ".integers (i) VALUES (45)";
+
+    // The first write finds the primary down, the following writes go to the warm standby.
+    auto first_query = executor.StartQuery(insert_stm, 10s).value().get();
+    REQUIRE(first_query->QueryStatus() == wing::QueryStatus::CONNECT_FAILURE);
+
+    auto second_query = executor.StartQuery(insert_stm, 10s).value().get();
+    query_print_error(second_query);
+    REQUIRE(second_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+}
+
+TEST_CASE("Circuit breaker fails queries fast while a server is down")
+{
+    using namespace std::chrono_literals;
+    // Nothing listens on port 1.
+    wing::ConnectionInfo connection { "127.0.0.1", 1, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::ExecutorOptions executor_options {};
+    executor_options.circuit_breaker.failure_ratio = 0.5;
+    executor_options.circuit_breaker.min_queries = 2;
+    executor_options.circuit_breaker.cool_down = 500ms;
+    wing::Executor executor { std::move(connection), 1, executor_options };
+
+    wing::Statement select_stm {};
+    select_stm << "SELECT 1";
+
+    for (std::size_t i = 0; i < 2; ++i) {
+        auto failed_query = executor.StartQuery(select_stm, 10s).value().get();
+        REQUIRE(failed_query->QueryStatus() == wing::QueryStatus::CONNECT_FAILURE);
+    }
+
+    auto rejected_query = executor.StartQuery(select_stm, 10s).value().get();
+    REQUIRE(rejected_query->QueryStatus() == wing::QueryStatus::CIRCUIT_OPEN);
+
+    // Once cooled down a probe is let through, its failure re-opens the breaker.
+    std::this_thread::sleep_for(600ms);
+    auto probe_query = executor.StartQuery(select_stm, 10s).value().get();
+    REQUIRE(probe_query->QueryStatus() == wing::QueryStatus::CONNECT_FAILURE);
+    auto reopened_query = executor.StartQuery(select_stm, 10s).value().get();
+    REQUIRE(reopened_query->QueryStatus() == wing::QueryStatus::CIRCUIT_OPEN);
+}
+
+TEST_CASE("Lock wait timeouts are retried with backoff")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo connection { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::ExecutorOptions executor_options {};
+    executor_options.retry.max_retries = 2;
+    executor_options.retry.backoff_initial = 1ms;
+    wing::Executor executor { std::move(connection), 2, executor_options };
+
+    // The transaction holds the row locks until it is rolled back.
+    auto transaction = executor.StartTransaction(10s).value();
+    wing::Statement lock_stm {};
+    lock_stm << "SELECT * FROM " << MYSQL_DATABASE << ".string FOR UPDATE";
+    auto lock_query = transaction.StartQuery(lock_stm, 10s).value().get();
+    REQUIRE(lock_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+
+    wing::Statement blocked_stm {};
+    blocked_stm << "SELECT /*+ SET_VAR(innodb_lock_wait_timeout=1) */ * FROM " << MYSQL_DATABASE << ".string FOR UPDATE";
+    auto blocked_query = executor.StartQuery(blocked_stm, 10s).value().get();
+    REQUIRE(blocked_query->QueryStatus() == wing::QueryStatus::ERROR);
+    REQUIRE(blocked_query->ErrorNumber() == ER_LOCK_WAIT_TIMEOUT);
+    REQUIRE(blocked_query->RetryCount() == 2);
+
+    REQUIRE(transaction.Rollback(10s).value().get()->QueryStatus() == wing::QueryStatus::SUCCESS);
+}
+
+TEST_CASE("Slow replica reads are hedged onto another replica")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo primary { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    std::vector<wing::ConnectionInfo> replicas {};
+    replicas.emplace_back(MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD);
+    replicas.emplace_back(MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD);
+    wing::ExecutorOptions executor_options {};
+    executor_options.hedge.percentile = 0.5;
+    executor_options.hedge.window = 10;
+    executor_options.hedge.min_delay = 50ms;
+    wing::Executor executor { std::move(primary), std::move(replicas), 2, executor_options };
+
+    // Learn the read latencies before anything is hedged.
+    wing::Statement select_stm {};
+    select_stm << "SELECT 1";
+    for (std::size_t i = 0; i < 5; ++i) {
+        auto query = executor.StartQuery(select_stm, 10s).value().get();
+        REQUIRE(query->QueryStatus() == wing::QueryStatus::SUCCESS);
+        REQUIRE_FALSE(query->Hedged());
+    }
+
+    // Only the first attempt gets the lock and sleeps, the duplicate returns right away.
+    wing::Statement slow_stm {};
+    slow_stm << "SELECT SLEEP(GET_LOCK('wing_hedge', 0) * 5)";
+    wing::QueryOptions slow_options {};
+    slow_options.route = wing::QueryRoute::REPLICA;
+
+    auto started = std::chrono::steady_clock::now();
+    auto slow_query = executor.StartQuery(slow_stm, 10s, slow_options).value().get();
+    query_print_error(slow_query);
+    REQUIRE(slow_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(slow_query->Hedged());
+    REQUIRE(std::chrono::steady_clock::now() - started < 5s);
+}
+
+TEST_CASE("Concurrency limit sheds queries over the server's limit")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo connection { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::ExecutorOptions executor_options {};
+    executor_options.concurrency_limit.initial_limit = 1;
+    executor_options.concurrency_limit.max_limit = 1;
+    executor_options.concurrency_limit.max_wait = 10ms;
+    wing::Executor executor { std::move(connection), 2, executor_options };
+
+    wing::Statement sleep_stm {};
+    sleep_stm << "SELECT SLEEP(1)";
+    auto sleep_future = executor.StartQuery(std::move(sleep_stm), 10s).value();
+    std::this_thread::sleep_for(100ms);
+
+    // Shed once it waited the max wait, not once the sleeping query frees its slot.
+    wing::Statement select_stm {};
+    select_stm << "SELECT 1";
+    auto started = std::chrono::steady_clock::now();
+    auto shed_query = executor.StartQuery(select_stm, 10s).value().get();
+    REQUIRE(shed_query->QueryStatus() == wing::QueryStatus::OVERLOADED);
+    REQUIRE(std::chrono::steady_clock::now() - started < 500ms);
+
+    REQUIRE(sleep_future.get()->QueryStatus() == wing::QueryStatus::SUCCESS);
+    auto admitted_query = executor.StartQuery(select_stm, 10s).value().get();
+    REQUIRE(admitted_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+}
+
+TEST_CASE("Queries over the concurrency limit wait without holding up a worker")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo connection { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::ExecutorOptions executor_options {};
+    executor_options.concurrency_limit.initial_limit = 1;
+    executor_options.concurrency_limit.max_limit = 1;
+    executor_options.concurrency_limit.max_wait = 10s;
+    executor_options.result_cache_max_bytes = 1024 * 1024;
+    wing::Executor executor { std::move(connection), 2, executor_options };
+
+    wing::QueryOptions cache_options {};
+    cache_options.cache_ttl = 60s;
+    wing::Statement cached_stm {};
+    cached_stm << "SELECT 'cached'";
+    REQUIRE(executor.StartQuery(cached_stm, 10s, cache_options).value().get()->QueryStatus() == wing::QueryStatus::SUCCESS);
+
+    wing::Statement sleep_stm {};
+    sleep_stm << "SELECT SLEEP(1)";
+    auto sleep_future = executor.StartQuery(std::move(sleep_stm), 10s).value();
+    std::this_thread::sleep_for(100ms);
+
+    wing::Statement select_stm {};
+    select_stm << "SELECT 1";
+    auto parked_future = executor.StartQuery(std::move(select_stm), 10s).value();
+    std::this_thread::sleep_for(100ms);
+
+    // The parked query doesn't hold the other worker, it still completes a cache hit right away.
+    auto started = std::chrono::steady_clock::now();
+    auto cached_query = executor.StartQuery(cached_stm, 10s, cache_options).value().get();
+    REQUIRE(cached_query->FromCache());
+    REQUIRE(std::chrono::steady_clock::now() - started < 500ms);
+
+    REQUIRE(sleep_future.get()->QueryStatus() == wing::QueryStatus::SUCCESS);
+    auto parked_query = parked_future.get();
+    query_print_error(parked_query);
+    REQUIRE(parked_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+}
+
+TEST_CASE("Queries parked by the concurrency limit complete when the executor stops")
+{
+    using namespace std::chrono_literals;
+    std::future<wing::QueryHandle> parked_future {};
+    {
+        wing::ConnectionInfo connection { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+        wing::ExecutorOptions executor_options {};
+        executor_options.concurrency_limit.initial_limit = 1;
+        executor_options.concurrency_limit.max_limit = 1;
+        executor_options.concurrency_limit.max_wait = 60s;
+        wing::Executor executor { std::move(connection), 2, executor_options };
+
+        wing::Statement sleep_stm {};
+        sleep_stm << "SELECT SLEEP(1)";
+        auto sleep_future = executor.StartQuery(std::move(sleep_stm), 10s).value();
+        std::this_thread::sleep_for(100ms);
+
+        wing::Statement select_stm {};
+        select_stm << "SELECT 1";
+        parked_future = executor.StartQuery(std::move(select_stm), 10s).value();
+        std::this_thread::sleep_for(100ms);
+        executor.Stop();
+    }
+
+    // The parked query may have been resumed by the sleep finishing before the workers exited.
+    auto parked_query = parked_future.get();
+    REQUIRE((parked_query->QueryStatus() == wing::QueryStatus::OVERLOADED
+        || parked_query->QueryStatus() == wing::QueryStatus::SUCCESS));
+}
+
+TEST_CASE("Tenants share the workers fairly")
+{
+    using namespace std::chrono_literals;
+    wing::ConnectionInfo connection { MYSQL_HOSTNAME, MYSQL_PORT, MYSQL_USERNAME, MYSQL_PASSWORD };
+    wing::Executor executor { std::move(connection), 1 };
+
+    std::atomic<std::size_t> completed { 0 };
+    std::atomic<std::size_t> noisy_completed { 0 };
+
+    wing::QueryOptions noisy_options {};
+    noisy_options.tenant = "noisy";
+    for (std::size_t i = 0; i < 50; ++i) {
+        wing::Statement sleep_stm {};
+        sleep_stm << "SELECT SLEEP(0.01)";
+        auto started = executor.StartQuery(
+            std::move(sleep_stm),
+            10s,
+            [&](wing::QueryHandle) {
+                ++noisy_completed;
+                ++completed;
+            },
+            noisy_options);
+        REQUIRE(started);
+    }
+
+    // The quiet tenant's query is served next instead of waiting behind the noisy tenant's.
+    wing::QueryOptions quiet_options {};
+    quiet_options.tenant = "quiet";
+    wing::Statement select_stm {};
+    select_stm << "SELECT 1";
+    auto quiet_query = executor.StartQuery(std::move(select_stm), 10s, quiet_options).value().get();
+    REQUIRE(quiet_query->QueryStatus() == wing::QueryStatus::SUCCESS);
+    REQUIRE(noisy_completed <= 2);
+
+    while (completed < 50) {
+        std::this_thread::sleep_for(10ms);
+    }
+}
@@ -19,6 +19,8 @@ static const std::string MYSQL_DATABASE = "wing_db";
 
 #include <wing/WingMySQL.hpp>
 
+#include <mysql/mysqld_error.h>
+
 auto query_print_error(
     wing::QueryHandle& query_handle) -> void
 {
@@ -107,4 +109,5 @@ struct TestSetupInfo {
     }
 } test_setup_info_instance;
 
+#include "ExecutorTest.hpp"
 #include "TableTest.hpp"